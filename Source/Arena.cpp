@@ -0,0 +1,257 @@
+/*!****************************************************************************
+\file     Arena.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all Arena class functions
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "Arena.h"
+#include "MemoryManager.h"
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: Arena
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Makes an empty arena, no page is taken until the first allocation
+
+\param pageSize
+  the number of bytes to take from the manager for each page
+******************************************************************************/
+Arena::Arena(size_t pageSize) :
+             mPageSize(pageSize),
+             mCursor(NULL),
+             mEnd(NULL),
+             mPages(NULL),
+             mPage(NULL),
+             mOversized(NULL),
+             mFinalizers(NULL),
+             mUsed(0)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Destroys every object made with Create and gives every page back to the
+  manager
+******************************************************************************/
+Arena::~Arena(void)
+{
+  Reset();
+
+  // while there are pages left
+  while (mPages)
+  {
+    Page* next = mPages->next;
+
+    Delete(mPages, mPages->size);
+    mPages = next;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Hands out memory by moving the pointer through the current page, the same
+  way the manager moves its heap
+
+\param size
+  the number of bytes to allocate
+
+\param alignment
+  a power of two the address must be a multiple of
+
+\return
+  a pointer to the memory, it lives until the arena is reset or destroyed
+******************************************************************************/
+void* Arena::Allocate(size_t size, size_t alignment)
+{
+  uintptr_t start = (uintptr_t)(mCursor);
+  uintptr_t memory = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+  size_t needed = (size_t)(memory - start) + size;
+
+  // if the current page does not have room
+  if (start == 0 || needed > (size_t)(mEnd - mCursor))
+  {
+    return AllocateSlow(size, alignment);
+  }
+
+  mCursor += needed;  // move the free space past the allocation
+  mUsed += needed;
+
+  return (void*)(memory);
+}
+
+/*!****************************************************************************
+\brief
+  Frees everything in the arena at once. The destructors of objects made with
+  Create are run newest first, oversized blocks go back to the manager and
+  allocation starts over at the first page, the pages are kept
+******************************************************************************/
+void Arena::Reset(void)
+{
+  RunFinalizers();
+
+  // while there are oversized blocks left
+  while (mOversized)
+  {
+    Page* next = mOversized->next;
+
+    Delete(mOversized, mOversized->size);
+    mOversized = next;
+  }
+
+  // if a page was ever taken
+  if (mPages)
+  {
+    UsePage(mPages);
+  }
+
+  mUsed = 0;
+}
+
+/*!****************************************************************************
+\brief
+  Gets the number of bytes handed out since the last reset
+
+\return
+  the bytes used, alignment padding included
+******************************************************************************/
+size_t Arena::Used(void) const
+{
+  return mUsed;
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Allocates when the current page is out of room. A size too big for a page
+  gets a block of its own from the manager, otherwise allocation moves on to
+  the next kept page or a new page from the manager
+
+\param size
+  the number of bytes to allocate
+
+\param alignment
+  a power of two the address must be a multiple of
+
+\return
+  a pointer to the memory
+******************************************************************************/
+void* Arena::AllocateSlow(size_t size, size_t alignment)
+{
+  size_t header = (sizeof(Page) + alignment - 1) & ~(alignment - 1); // keeps the first allocation of a page aligned
+
+  // if the size would not fit in an empty page
+  if (header + size > mPageSize)
+  {
+    size_t blockSize = sizeof(Page) + alignment - 1 + size;
+    Page* block = static_cast<Page*>(Alloc(blockSize));
+
+    block->next = mOversized;
+    block->size = blockSize;
+    mOversized = block;
+    mUsed += size;
+
+    return (void*)(((uintptr_t)(block + 1) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+  }
+
+  // if there is no kept page after the current one
+  if (mPage == NULL || mPage->next == NULL)
+  {
+    Page* page = static_cast<Page*>(Alloc(mPageSize));
+
+    page->next = NULL;
+    page->size = mPageSize;
+
+    // if this is the first page
+    if (mPage == NULL)
+    {
+      mPages = page;
+    }
+    else
+    {
+      mPage->next = page;
+    }
+
+    UsePage(page);
+  }
+  else
+  {
+    UsePage(mPage->next);
+  }
+
+  return Allocate(size, alignment);
+}
+
+/*!****************************************************************************
+\brief
+  Makes a page the one allocations come from
+
+\param page
+  the page to allocate from
+******************************************************************************/
+void Arena::UsePage(Page* page)
+{
+  mPage = page;
+  mCursor = (char*)(page + 1);
+  mEnd = (char*)(page) + page->size;
+}
+
+/*!****************************************************************************
+\brief
+  Runs the destructor of every object made with Create, newest first
+******************************************************************************/
+void Arena::RunFinalizers(void)
+{
+  // while there are objects left to destroy
+  while (mFinalizers)
+  {
+    Finalizer* finalizer = mFinalizers;
+
+    mFinalizers = finalizer->next;  // unlink first, the destructor may allocate in the arena
+    finalizer->destroy(finalizer->object);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,136 @@
+/*!****************************************************************************
+\file     Arena.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the Arena class, a region that bump allocates from pages of the
+  manager and frees everything in it at once
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t ARENA_PAGE_SIZE = 64 * 1024;   //!< the default number of bytes taken from the manager for each page of an arena
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! A monotonic region for objects that all die together, such as everything a
+//! request or a frame allocates. Allocation moves a pointer through the
+//! current page and no block gets a header. Reset frees everything at once by
+//! moving the pointer back to the first page, the pages are kept for the next
+//! round and go back to the manager when the arena is destroyed. Only objects
+//! made with Create have their destructors run. An arena is used by a single
+//! thread
+class Arena
+{
+  public:
+
+    Arena(size_t pageSize = ARENA_PAGE_SIZE);
+    ~Arena(void);
+
+    Arena(const Arena& rhs) = delete;
+    Arena& operator=(const Arena& rhs) = delete;
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void Reset(void);
+
+    size_t Used(void) const;
+
+    /*!************************************************************************
+    \brief
+      Constructs an object in the arena, if T has a destructor it is run when
+      the arena is reset or destroyed, the newest object first
+
+    \param args
+      the arguments forwarded to the constructor of T
+
+    \return
+      the new object
+    **************************************************************************/
+    template <class T, class... Args>
+    T* Create(Args&&... args)
+    {
+      // if T has nothing to destroy
+      if (std::is_trivially_destructible<T>::value)
+      {
+        return new(Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+      }
+
+      Finalizer* finalizer = static_cast<Finalizer*>(Allocate(sizeof(Finalizer), alignof(Finalizer)));
+      T* object = new(Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+      finalizer->destroy = &Arena::DestroyObject<T>;
+      finalizer->object = object;
+      finalizer->next = mFinalizers;  // registered only once the object is built
+      mFinalizers = finalizer;
+
+      return object;
+    }
+
+  private:
+
+    //! The start of every page and oversized block taken from the manager
+    struct Page
+    {
+      Page* next;   //!< the next page in the list
+      size_t size;  //!< the number of bytes taken from the manager, this header included
+    };
+
+    //! A destructor to run when the arena is reset
+    struct Finalizer
+    {
+      void (*destroy)(void*); //!< destroys the object as its real type
+      void* object;           //!< the object to destroy
+      Finalizer* next;        //!< the finalizer registered before this one
+    };
+
+    size_t mPageSize;         //!< the number of bytes taken from the manager for each page
+    char* mCursor;            //!< the first unused byte of the current page
+    char* mEnd;               //!< the end of the current page
+    Page* mPages;             //!< every page, in the order they are used
+    Page* mPage;              //!< the page allocations are coming from
+    Page* mOversized;         //!< blocks too big for a page, given back on every reset
+    Finalizer* mFinalizers;   //!< objects to destroy, newest first
+    size_t mUsed;             //!< the bytes handed out since the last reset, padding included
+
+    void* AllocateSlow(size_t size, size_t alignment);
+    void UsePage(Page* page);
+    void RunFinalizers(void);
+
+    template <class T>
+    static void DestroyObject(void* object)
+    {
+      static_cast<T*>(object)->~T();
+    }
+};
@@ -14,10 +14,41 @@
 // Include Files
 //-----------------------------------------------------------------------------
 
+#include "Arena.h"
+#include "MemoryAllocator.h"
 #include "MemoryManager.h"
+#include "MemoryResource.h"
+#include "ObjectPool.h"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <random>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 //-----------------------------------------------------------------------------
 // Private Consts
@@ -42,6 +73,42 @@ Temp temp("Test");
 // Private Classes
 //-----------------------------------------------------------------------------
 
+//! A node of the pointer chasing benchmark, a cache line in size
+struct ChaseNode
+{
+  ChaseNode* next;  //!< the next node to visit
+  char pad[56];     //!< fills the rest of the cache line
+};
+
+//! The header of a block from the exact size free lists the fragmentation
+//! benchmark compares against, the way the manager reused memory before free
+//! blocks were merged with their neighbours
+struct NoMergeBlock
+{
+  size_t size;        //!< the size class of the block in grains
+  NoMergeBlock* next; //!< the next free block of the same class, while free
+};
+
+//! A node of the small node benchmark, the size of a typical list or tree node
+struct SmallNode
+{
+  SmallNode* next;  //!< the next node in the list
+  size_t value;     //!< the payload summed by the walk
+};
+
+//! An object of the pool benchmark, the kind of small type created and
+//! destroyed at a high rate
+struct Particle
+{
+  Particle(float x, float y, int life) : x(x), y(y), dx(0), dy(0), life(life) {}
+
+  float x;    //!< the horizontal position
+  float y;    //!< the vertical position
+  float dx;   //!< the horizontal speed
+  float dy;   //!< the vertical speed
+  int life;   //!< the frames left to live
+};
+
 //-----------------------------------------------------------------------------
 // Private Functions
 //-----------------------------------------------------------------------------
@@ -50,6 +117,104 @@ std::chrono::system_clock::time_point GetTime(void);
 
 void PrintTimeDiff(const std::chrono::system_clock::time_point& startTime, const std::string& testName);
 
+size_t PeakRSS(void);
+
+size_t CurrentRSS(void);
+
+int OpenCounter(unsigned long long config);
+
+long long CloseCounter(int counter);
+
+void SmallNodeRun(void* (*allocate)(size_t), void (*destroy)(void*), const std::string& testName);
+
+void SmallNodeBenchmark(void);
+
+void* NoMergeAllocate(size_t size);
+
+void NoMergeDestroy(void* ptr);
+
+void NoMergeRelease(void);
+
+void FragmentationRun(void* (*allocate)(size_t), void (*destroy)(void*), const std::string& testName);
+
+void FragmentationBenchmark(void);
+
+void ThreadScalingWork(unsigned int seed, int operations);
+
+void ThreadScalingBenchmark(void);
+
+double ProducerConsumerRun(void* (*allocate)(size_t), void (*destroy)(void*), int messages);
+
+void ProducerConsumerBenchmark(void);
+
+std::vector<ChaseNode*> BuildChase(size_t nodeCount, std::mt19937& random);
+
+void RunChase(ChaseNode* start, size_t hops, const std::string& testName);
+
+void TLBBenchmark(void);
+
+void SizedDeleteRun(size_t size, bool sized);
+
+void SizedDeleteBenchmark(void);
+
+template <class Create, class Destroy>
+void ObjectPoolRun(Create create, Destroy destroy, const std::string& testName);
+
+void ObjectPoolBenchmark(void);
+
+void ArenaBenchmark(void);
+
+void ResourceRun(std::pmr::memory_resource* resource, const std::string& testName);
+
+void ResourceBenchmark(void);
+
+template <class MakeAllocator>
+void NodeContainerRun(MakeAllocator makeAllocator, const std::string& testName);
+
+void NodeContainerBenchmark(void);
+
+void BatchRun(size_t size, bool batched);
+
+void BatchBenchmark(void);
+
+void* ManagerGrow(void* ptr, size_t oldSize, size_t newSize);
+
+void* MallocGrow(void* ptr, size_t oldSize, size_t newSize);
+
+void* CopyGrow(void* ptr, size_t oldSize, size_t newSize);
+
+void GrowthRun(void* (*grow)(void*, size_t, size_t), void (*destroy)(void*), const std::string& testName);
+
+void GrowthBenchmark(void);
+
+void DecayRun(bool background, const std::string& testName);
+
+void DecayBenchmark(void);
+
+void ConfigWork(const MemoryConfig& config);
+
+void ConfigRun(size_t pageSize, size_t pageGrowth, size_t largeThreshold);
+
+void ConfigSweepBenchmark(void);
+
+void StatsBenchmark(void);
+
+//-----------------------------------------------------------------------------
+// Private Variables
+//-----------------------------------------------------------------------------
+
+const size_t NO_MERGE_GRAIN = 16;                   //!< the sizes of the exact size lists are multiples of this
+const size_t NO_MERGE_CLASSES = 4096 / NO_MERGE_GRAIN + 2;  //!< one list per size up to the biggest benchmark block and its header
+const size_t NO_MERGE_CHUNK_SIZE = 1024 * 1024;     //!< the bytes mapped at once for new blocks
+
+NoMergeBlock* noMergeFree[NO_MERGE_CLASSES];  //!< the freed blocks of every size, only reused for that exact size
+
+std::vector<void*> noMergeChunks;             //!< every chunk mapped, unmapped by NoMergeRelease
+
+char* noMergeCursor = NULL;                   //!< the next unused byte of the newest chunk
+
+char* noMergeEnd = NULL;                      //!< the end of the newest chunk
+
 //-----------------------------------------------------------------------------
 // Public Functions
 //-----------------------------------------------------------------------------
@@ -78,6 +243,36 @@ int main(void)
 
   PrintTimeDiff(startTime, "new");
 
+  SmallNodeBenchmark();
+
+  FragmentationBenchmark();
+
+  ThreadScalingBenchmark();
+
+  ProducerConsumerBenchmark();
+
+  TLBBenchmark();
+
+  SizedDeleteBenchmark();
+
+  ObjectPoolBenchmark();
+
+  ArenaBenchmark();
+
+  ResourceBenchmark();
+
+  NodeContainerBenchmark();
+
+  BatchBenchmark();
+
+  GrowthBenchmark();
+
+  DecayBenchmark();
+
+  ConfigSweepBenchmark();
+
+  StatsBenchmark();
+
   MemoryManagerShutdown();
 
   return 0;
@@ -132,4 +327,1541 @@ void PrintTimeDiff(const std::chrono::system_clock::time_point& startTime, const
   std::chrono::duration<double> diff = GetTime() - startTime;
 
   std::cout << "It took " << diff.count() << " time to complete " << testName << std::endl;
-}
\ No newline at end of file
+}
+
+/*!****************************************************************************
+\brief
+  Gets the most memory the process has had resident at one time
+
+\return
+  the peak resident set size in kilobytes
+******************************************************************************/
+size_t PeakRSS(void)
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+  return counters.PeakWorkingSetSize / 1024;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  return (size_t)(usage.ru_maxrss);
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Gets the memory the process has resident right now
+
+\return
+  the resident set size in kilobytes
+******************************************************************************/
+size_t CurrentRSS(void)
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+  return counters.WorkingSetSize / 1024;
+#elif defined(__linux__)
+  FILE* file = fopen("/proc/self/statm", "r");
+  size_t size = 0;
+  size_t resident = 0;
+
+  // if the process statistics could be read
+  if (file)
+  {
+    fscanf(file, "%zu %zu", &size, &resident);
+    fclose(file);
+  }
+
+  return resident * (size_t)(sysconf(_SC_PAGESIZE)) / 1024;
+#else
+  return PeakRSS();
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Starts counting a hardware cache event for the calling thread in user code
+
+\param config
+  the PERF_TYPE_HW_CACHE event to count
+
+\return
+  the counter, -1 if hardware counters can not be read
+******************************************************************************/
+int OpenCounter(unsigned long long config)
+{
+#if defined(__linux__)
+  perf_event_attr attr = {};
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  int counter = (int)(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+
+  // if the counter could be opened
+  if (counter >= 0)
+  {
+    ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  return counter;
+#else
+  return -1;
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Stops a counter from OpenCounter and reads its count
+
+\param counter
+  the counter, -1 is allowed
+
+\return
+  the number of events counted, -1 if they were not counted
+******************************************************************************/
+long long CloseCounter(int counter)
+{
+  long long count = -1;
+
+#if defined(__linux__)
+  // if the counter was opened
+  if (counter >= 0)
+  {
+    ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+
+    // if the count could not be read
+    if (read(counter, &count, sizeof(count)) != sizeof(count))
+    {
+      count = -1;
+    }
+
+    close(counter);
+  }
+#endif
+
+  return count;
+}
+
+/*!****************************************************************************
+\brief
+  Builds a long list of 16 byte nodes, walks it and frees it, printing how
+  many bytes each live node costs and how long the walk took
+
+\param allocate
+  the function used to allocate nodes
+
+\param destroy
+  the function used to free nodes
+
+\param testName
+  the name printed with the results
+******************************************************************************/
+void SmallNodeRun(void* (*allocate)(size_t), void (*destroy)(void*), const std::string& testName)
+{
+  const size_t nodeCount = 1000000;
+
+  size_t startRSS = CurrentRSS();
+  SmallNode* head = NULL;
+
+  // build the list front to back
+  for (size_t i = 0; i < nodeCount; ++i)
+  {
+    SmallNode* node = (SmallNode*)allocate(sizeof(SmallNode));
+
+    node->next = head;
+    node->value = i;
+    head = node;
+  }
+
+  size_t bytes = (CurrentRSS() - startRSS) * 1024;
+  size_t sum = 0;
+  auto startTime = GetTime();
+
+  // walk the list ten times
+  for (int pass = 0; pass < 10; ++pass)
+  {
+    for (SmallNode* node = head; node; node = node->next)
+    {
+      sum += node->value;
+    }
+  }
+
+  PrintTimeDiff(startTime, testName + " small node walk");
+
+  std::cout << testName << " small nodes: " << (double)(bytes) / nodeCount << " bytes per live node (sum " << sum << ")" << std::endl;
+
+  // free the list
+  while (head)
+  {
+    SmallNode* next = head->next;
+
+    destroy(head);
+    head = next;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Compares the memory cost of many small nodes in the manager against malloc
+******************************************************************************/
+void SmallNodeBenchmark(void)
+{
+  SmallNodeRun(Alloc, Delete, "MemoryManager");
+  SmallNodeRun(malloc, free, "malloc");
+}
+
+/*!****************************************************************************
+\brief
+  Allocates from exact size free lists that never merge or split a block, a
+  freed block only satisfies a later request that rounds to the same size
+
+\param size
+  the number of bytes to allocate, at most 4096
+
+\return
+  a pointer to the allocated memory
+******************************************************************************/
+void* NoMergeAllocate(size_t size)
+{
+  size_t grains = (size + sizeof(NoMergeBlock) + NO_MERGE_GRAIN - 1) / NO_MERGE_GRAIN;
+  NoMergeBlock* block = noMergeFree[grains];
+
+  // if a block of exactly this size was freed
+  if (block)
+  {
+    noMergeFree[grains] = block->next;
+    return block + 1;
+  }
+
+  size_t bytes = grains * NO_MERGE_GRAIN;
+
+  // if the newest chunk is used up
+  if (noMergeCursor == NULL || (size_t)(noMergeEnd - noMergeCursor) < bytes)
+  {
+    noMergeCursor = (char*)(MemoryManagerMapPages(NO_MERGE_CHUNK_SIZE));
+    noMergeEnd = noMergeCursor + NO_MERGE_CHUNK_SIZE;
+    noMergeChunks.push_back(noMergeCursor);
+  }
+
+  block = (NoMergeBlock*)(noMergeCursor);
+  block->size = grains;
+  noMergeCursor += bytes;
+
+  return block + 1;
+}
+
+/*!****************************************************************************
+\brief
+  Puts a block from NoMergeAllocate on the free list of its exact size
+
+\param ptr
+  the block to free
+******************************************************************************/
+void NoMergeDestroy(void* ptr)
+{
+  NoMergeBlock* block = (NoMergeBlock*)(ptr) - 1;
+
+  block->next = noMergeFree[block->size];
+  noMergeFree[block->size] = block;
+}
+
+/*!****************************************************************************
+\brief
+  Unmaps every chunk of the exact size lists once a run is done
+******************************************************************************/
+void NoMergeRelease(void)
+{
+  // for all chunks
+  for (void* chunk : noMergeChunks)
+  {
+    MemoryManagerUnmapPages(chunk, NO_MERGE_CHUNK_SIZE);
+  }
+
+  // the list's own memory is given back now, the manager is shut down before
+  // static destructors run and could no longer tell it was the manager's
+  std::vector<void*>().swap(noMergeChunks);
+  memset(noMergeFree, 0, sizeof(noMergeFree));
+  noMergeCursor = NULL;
+  noMergeEnd = NULL;
+}
+
+/*!****************************************************************************
+\brief
+  Churns mixed sizes through an allocator, each round fills the heap with
+  small blocks, frees them in a random order and then asks for blocks too big
+  for any of the small holes. Without merging neighbours every round needs
+  new memory, so the resident set keeps growing
+
+\param allocate
+  the function to allocate with
+
+\param destroy
+  the function to free with
+
+\param testName
+  the name printed with the results
+******************************************************************************/
+void FragmentationRun(void* (*allocate)(size_t), void (*destroy)(void*), const std::string& testName)
+{
+  const int rounds = 20;
+  const int smallCount = 40000;
+  const int largeCount = 2000;
+
+  std::mt19937 random(1234);
+  std::uniform_int_distribution<size_t> smallSize(16, 256);
+  std::uniform_int_distribution<size_t> largeSize(1000, 4000);
+
+  std::vector<void*> blocks;
+  blocks.reserve(smallCount);
+
+  size_t startRSS = CurrentRSS();
+  size_t peakRSS = startRSS;
+  auto startTime = GetTime();
+
+  // for all rounds of churn
+  for (int round = 0; round < rounds; ++round)
+  {
+    // fill with small blocks
+    for (int i = 0; i < smallCount; ++i)
+    {
+      blocks.push_back(allocate(smallSize(random)));
+    }
+
+    peakRSS = std::max(peakRSS, CurrentRSS());
+
+    std::shuffle(blocks.begin(), blocks.end(), random);
+
+    // free them in a random order
+    for (void* block : blocks)
+    {
+      destroy(block);
+    }
+
+    blocks.clear();
+
+    // ask for blocks that only fit in merged space
+    for (int i = 0; i < largeCount; ++i)
+    {
+      blocks.push_back(allocate(largeSize(random)));
+    }
+
+    peakRSS = std::max(peakRSS, CurrentRSS());
+
+    // free the large blocks
+    for (void* block : blocks)
+    {
+      destroy(block);
+    }
+
+    blocks.clear();
+  }
+
+  PrintTimeDiff(startTime, testName + " fragmentation churn");
+
+  std::cout << testName << " peak RSS grew by " << peakRSS - startRSS << " KB during fragmentation churn" << std::endl;
+}
+
+/*!****************************************************************************
+\brief
+  Compares how far the resident set grows under mixed size churn in the
+  manager, which merges free neighbours, in exact size lists that never merge
+  and in malloc
+******************************************************************************/
+void FragmentationBenchmark(void)
+{
+  FragmentationRun(Alloc, Delete, "MemoryManager");
+  FragmentationRun(NoMergeAllocate, NoMergeDestroy, "no merging");
+  NoMergeRelease();
+  FragmentationRun(malloc, free, "malloc");
+}
+
+/*!****************************************************************************
+\brief
+  The work done by each thread of the scaling benchmark, keeps a small set of
+  live blocks and replaces a random one on every operation. Half the sizes are
+  too big for the thread cache so the arenas see real traffic
+
+\param seed
+  the seed for the thread's sizes and slots
+
+\param operations
+  the number of blocks to allocate and free
+******************************************************************************/
+void ThreadScalingWork(unsigned int seed, int operations)
+{
+  const int slotCount = 64;
+
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<size_t> size(16, 2048);
+  std::uniform_int_distribution<int> slot(0, slotCount - 1);
+
+  void* slots[slotCount] = {};
+
+  // for all operations
+  for (int i = 0; i < operations; ++i)
+  {
+    int index = slot(random);
+
+    // if the slot holds a block
+    if (slots[index])
+    {
+      Delete(slots[index]);
+    }
+
+    slots[index] = Alloc(size(random));
+  }
+
+  // free whatever is left
+  for (void* block : slots)
+  {
+    if (block)
+    {
+      Delete(block);
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Runs the same work per thread from 1 up to 64 threads and prints the total
+  throughput along with how often a thread found an arena lock held
+******************************************************************************/
+void ThreadScalingBenchmark(void)
+{
+  const int operations = 100000;
+
+  std::cout << "Arenas: " << MemoryManagerArenaCount() << std::endl;
+
+  // for all thread counts, doubling each time
+  for (unsigned int threadCount = 1; threadCount <= 64; threadCount *= 2)
+  {
+    size_t startContention = 0;
+
+    // for all arenas
+    for (unsigned int i = 0; i < MemoryManagerArenaCount(); ++i)
+    {
+      startContention += MemoryManagerArenaContention(i);
+    }
+
+    std::vector<std::thread> threads;
+    auto startTime = GetTime();
+
+    // start every thread
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+      threads.emplace_back(ThreadScalingWork, i + 1, operations);
+    }
+
+    // wait for every thread
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+
+    std::chrono::duration<double> diff = GetTime() - startTime;
+    size_t contention = 0;
+
+    // for all arenas
+    for (unsigned int i = 0; i < MemoryManagerArenaCount(); ++i)
+    {
+      contention += MemoryManagerArenaContention(i);
+    }
+
+    std::cout << threadCount << " threads: " << (threadCount * operations) / diff.count() << " ops/sec, "
+              << contention - startContention << " contended locks" << std::endl;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Passes messages from a producer thread to a consumer thread through a ring,
+  the producer allocates and fills every message and the consumer reads and
+  frees it, so every free is of a block another thread allocated
+
+\param allocate
+  the function used to allocate messages
+
+\param destroy
+  the function used to free messages
+
+\param messages
+  the number of messages to pass
+
+\return
+  the number of messages passed per second
+******************************************************************************/
+double ProducerConsumerRun(void* (*allocate)(size_t), void (*destroy)(void*), int messages)
+{
+  const size_t ringSize = 1024;
+
+  std::vector<std::atomic<void*>> ring(ringSize);
+  std::atomic<size_t> checksum(0);
+
+  auto startTime = GetTime();
+
+  std::thread producer([&]()
+  {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<size_t> size(32, 512);
+
+    // for all messages
+    for (int i = 0; i < messages; ++i)
+    {
+      size_t messageSize = size(random);
+      char* message = (char*)allocate(messageSize);
+      std::atomic<void*>& slot = ring[i % ringSize];
+
+      memset(message, i & 0xFF, messageSize);
+
+      // while the consumer has not emptied the slot
+      while (slot.load(std::memory_order_acquire))
+      {
+        std::this_thread::yield();
+      }
+
+      slot.store(message, std::memory_order_release);
+    }
+  });
+
+  std::thread consumer([&]()
+  {
+    size_t sum = 0;
+
+    // for all messages
+    for (int i = 0; i < messages; ++i)
+    {
+      std::atomic<void*>& slot = ring[i % ringSize];
+      void* message;
+
+      // while the producer has not filled the slot
+      while ((message = slot.load(std::memory_order_acquire)) == NULL)
+      {
+        std::this_thread::yield();
+      }
+
+      slot.store(NULL, std::memory_order_release);
+      sum += *(unsigned char*)message;
+      destroy(message);
+    }
+
+    checksum = sum;
+  });
+
+  producer.join();
+  consumer.join();
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+
+  return messages / diff.count();
+}
+
+/*!****************************************************************************
+\brief
+  Compares the manager against malloc and free when every block is freed by
+  a different thread than the one that allocated it
+******************************************************************************/
+void ProducerConsumerBenchmark(void)
+{
+  const int messages = 1000000;
+
+  std::cout << "Producer/consumer MemoryManager: " << ProducerConsumerRun(Alloc, Delete, messages) << " messages/sec" << std::endl;
+  std::cout << "Producer/consumer malloc: " << ProducerConsumerRun(malloc, free, messages) << " messages/sec" << std::endl;
+}
+
+/*!****************************************************************************
+\brief
+  Allocates nodes one at a time and links them into a single loop in a
+  random order, so every hop lands somewhere unrelated in memory
+
+\param nodeCount
+  the number of nodes to allocate
+
+\param random
+  the generator used to shuffle the loop
+
+\return
+  the nodes in the order they were allocated
+******************************************************************************/
+std::vector<ChaseNode*> BuildChase(size_t nodeCount, std::mt19937& random)
+{
+  std::vector<ChaseNode*> nodes(nodeCount);
+
+  // for all nodes
+  for (size_t i = 0; i < nodeCount; ++i)
+  {
+    nodes[i] = (ChaseNode*)Alloc(sizeof(ChaseNode));
+  }
+
+  std::vector<ChaseNode*> order(nodes);
+  std::shuffle(order.begin(), order.end(), random);
+
+  // for all nodes in the shuffled order
+  for (size_t i = 0; i < nodeCount; ++i)
+  {
+    order[i]->next = order[(i + 1) % nodeCount];
+  }
+
+  return nodes;
+}
+
+/*!****************************************************************************
+\brief
+  Follows a loop of nodes and prints the time per hop, along with the data
+  TLB misses when the hardware counters can be read
+
+\param start
+  the node to start from
+
+\param hops
+  the number of nodes to visit
+
+\param testName
+  the name printed with the results
+******************************************************************************/
+void RunChase(ChaseNode* start, size_t hops, const std::string& testName)
+{
+#if defined(__linux__)
+  int counter = OpenCounter(PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+  int counter = -1;
+#endif
+
+  auto startTime = GetTime();
+  ChaseNode* node = start;
+
+  // for all hops
+  for (size_t i = 0; i < hops; ++i)
+  {
+    node = node->next;
+  }
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+
+  long long misses = CloseCounter(counter);
+
+  std::cout << testName << ": " << diff.count() * 1e9 / hops << " ns per hop";
+
+  // if the misses were counted
+  if (misses >= 0)
+  {
+    std::cout << ", " << misses << " dTLB misses";
+  }
+  else
+  {
+    std::cout << ", dTLB misses not available";
+  }
+
+  std::cout << (node == NULL ? " " : "") << std::endl; // keeps the loop from being optimized away
+}
+
+/*!****************************************************************************
+\brief
+  Chases pointers through 64 MiB of nodes carved from normal pages and then
+  through the same amount carved from chunks backed by huge pages. With huge
+  pages each TLB entry covers 512 times more memory so far fewer hops miss
+******************************************************************************/
+void TLBBenchmark(void)
+{
+  const size_t nodeCount = size_t(1) << 20;
+  const size_t hops = size_t(1) << 22;
+
+  std::mt19937 random(99);
+
+  MemoryManagerHugePages(MEMORY_HUGE_PAGES_OFF);
+  std::vector<ChaseNode*> smallPages = BuildChase(nodeCount, random);
+
+  MemoryManagerHugePages(MEMORY_HUGE_PAGES_ADVISE);
+  std::vector<ChaseNode*> hugePages = BuildChase(nodeCount, random);
+
+  MemoryManagerHugePages(MEMORY_HUGE_PAGES_OFF);
+
+  RunChase(smallPages[0], hops, "Pointer chase 4 KiB pages");
+  RunChase(hugePages[0], hops, "Pointer chase huge pages");
+
+  // free both loops
+  for (size_t i = 0; i < nodeCount; ++i)
+  {
+    Delete(smallPages[i]);
+    Delete(hugePages[i]);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Frees blocks scattered through memory in a random order after the cache has
+  been flushed of them, printing the cache misses and time per free
+
+\param size
+  the size of every block
+
+\param sized
+  true to free with the size, false to let the manager find it
+******************************************************************************/
+void SizedDeleteRun(size_t size, bool sized)
+{
+  const size_t blockCount = 200000;
+
+  std::mt19937 random(11);
+  std::vector<void*> blocks(blockCount);
+  std::vector<char> evict(size_t(64) << 20);
+
+  // for all blocks
+  for (void*& block : blocks)
+  {
+    block = Alloc(size);
+  }
+
+  std::shuffle(blocks.begin(), blocks.end(), random);
+  memset(evict.data(), 1, evict.size()); // push the blocks out of the cache
+
+#if defined(__linux__)
+  int counter = OpenCounter(PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+  int counter = -1;
+#endif
+
+  auto startTime = GetTime();
+
+  // for all blocks
+  for (void* block : blocks)
+  {
+    // if the size is passed along
+    if (sized)
+    {
+      Delete(block, size);
+    }
+    else
+    {
+      Delete(block);
+    }
+  }
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+  long long misses = CloseCounter(counter);
+
+  std::cout << (sized ? "Delete(ptr, " : "Delete(ptr) of ") << size << (sized ? "): " : ": ") << diff.count() * 1e9 / blockCount << " ns per free";
+
+  // if the misses were counted
+  if (misses >= 0)
+  {
+    std::cout << ", " << (double)(misses) / blockCount << " L1D misses per free" << std::endl;
+  }
+  else
+  {
+    std::cout << ", L1D misses not available" << std::endl;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Compares freeing with and without the size for a slab size class and for a
+  size class whose blocks have headers
+******************************************************************************/
+void SizedDeleteBenchmark(void)
+{
+  SizedDeleteRun(16, false);
+  SizedDeleteRun(16, true);
+  SizedDeleteRun(512, false);
+  SizedDeleteRun(512, true);
+}
+
+/*!****************************************************************************
+\brief
+  Keeps a window of live particles and replaces a random one on every step,
+  printing the time per create and destroy pair
+
+\param create
+  makes a particle from a position and a life
+
+\param destroy
+  destroys a particle from create
+
+\param testName
+  the name printed with the results
+******************************************************************************/
+template <class Create, class Destroy>
+void ObjectPoolRun(Create create, Destroy destroy, const std::string& testName)
+{
+  const size_t liveCount = 4096;
+  const size_t steps = 10000000;
+
+  std::mt19937 random(5);
+  std::vector<Particle*> live(liveCount);
+
+  // for all slots
+  for (Particle*& particle : live)
+  {
+    particle = create(0.0f, 0.0f, 0);
+  }
+
+  auto startTime = GetTime();
+
+  // for all steps
+  for (size_t i = 0; i < steps; ++i)
+  {
+    Particle*& particle = live[random() % liveCount];
+
+    destroy(particle);
+    particle = create((float)(i), 1.0f, (int)(i));
+  }
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+
+  std::cout << testName << ": " << diff.count() * 1e9 / steps << " ns per create and destroy" << std::endl;
+
+  // free whatever is left
+  for (Particle* particle : live)
+  {
+    destroy(particle);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Compares new and delete against an ObjectPool with and without its front
+  cache
+******************************************************************************/
+void ObjectPoolBenchmark(void)
+{
+  ObjectPool<Particle> pool;
+
+  ObjectPoolRun([](float x, float y, int life) { return new Particle(x, y, life); },
+                [](Particle* particle) { delete particle; }, "new and delete");
+
+  ObjectPoolRun([&pool](float x, float y, int life) { return pool.Create(x, y, life); },
+                [&pool](Particle* particle) { pool.Destroy(particle); }, "ObjectPool");
+
+  ObjectPool<Particle>::Cache cache(pool);
+
+  ObjectPoolRun([&cache](float x, float y, int life) { return cache.Create(x, y, life); },
+                [&cache](Particle* particle) { cache.Destroy(particle); }, "ObjectPool with cache");
+}
+
+/*!****************************************************************************
+\brief
+  Compares freeing every object of a frame one at a time against an Arena
+  that frees the whole frame with a single Reset
+******************************************************************************/
+void ArenaBenchmark(void)
+{
+  const size_t frames = 2000;
+  const size_t objectCount = 5000;
+
+  std::mt19937 random(6);
+  std::vector<size_t> sizes(objectCount);
+  std::vector<void*> objects(objectCount);
+
+  // for all objects in a frame
+  for (size_t& size : sizes)
+  {
+    size = 8 + random() % 248;
+  }
+
+  auto startTime = GetTime();
+
+  // for all frames
+  for (size_t frame = 0; frame < frames; ++frame)
+  {
+    // for all objects in the frame
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+      objects[i] = Alloc(sizes[i]);
+      memset(objects[i], (int)(i), sizes[i]);
+    }
+
+    // for all objects in the frame
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+      Delete(objects[i], sizes[i]);
+    }
+  }
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+
+  std::cout << "Frame with Alloc and Delete: " << diff.count() * 1e9 / (frames * objectCount) << " ns per object" << std::endl;
+
+  Arena arena;
+
+  startTime = GetTime();
+
+  // for all frames
+  for (size_t frame = 0; frame < frames; ++frame)
+  {
+    // for all objects in the frame
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+      objects[i] = arena.Allocate(sizes[i]);
+      memset(objects[i], (int)(i), sizes[i]);
+    }
+
+    arena.Reset();
+  }
+
+  diff = GetTime() - startTime;
+
+  std::cout << "Frame with Arena: " << diff.count() * 1e9 / (frames * objectCount) << " ns per object" << std::endl;
+}
+
+/*!****************************************************************************
+\brief
+  Fills and churns a pmr map of strings and a pmr vector through a resource
+
+\param resource
+  the resource the containers allocate from
+
+\param testName
+  the name printed with the results
+******************************************************************************/
+void ResourceRun(std::pmr::memory_resource* resource, const std::string& testName)
+{
+  const int keyCount = 100000;
+  const int rounds = 10;
+
+  auto startTime = GetTime();
+
+  // for all rounds
+  for (int round = 0; round < rounds; ++round)
+  {
+    std::pmr::unordered_map<int, std::pmr::string> map(resource);
+    std::pmr::vector<int> keys(resource);
+
+    // for all keys
+    for (int i = 0; i < keyCount; ++i)
+    {
+      map.emplace(i, std::pmr::string("a value too long for the small string buffer", resource));
+      keys.push_back(i);
+
+      // if an older key should be replaced
+      if (i % 2 == 1)
+      {
+        map.erase(keys[i / 2]);
+      }
+    }
+  }
+
+  PrintTimeDiff(startTime, testName);
+}
+
+/*!****************************************************************************
+\brief
+  Compares pmr containers on the default new and delete resource, the
+  standard pools and the manager's resources
+******************************************************************************/
+void ResourceBenchmark(void)
+{
+  ResourceRun(std::pmr::new_delete_resource(), "pmr new_delete_resource");
+
+  {
+    std::pmr::unsynchronized_pool_resource pool;
+
+    ResourceRun(&pool, "pmr unsynchronized_pool_resource");
+  }
+
+  ResourceRun(MemoryManagerGetResource(), "pmr MemoryManagerResource");
+
+  {
+    MemoryHeapResource heap(0);
+
+    ResourceRun(&heap, "pmr MemoryHeapResource");
+  }
+
+  {
+    MemoryPoolResource pool;
+
+    ResourceRun(&pool, "pmr MemoryPoolResource");
+  }
+
+  {
+    Arena arena;
+    ArenaResource resource(arena);
+
+    ResourceRun(&resource, "pmr ArenaResource");
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Inserts into and erases from a list, a map and an unordered map, each with
+  an allocator of its own
+
+\param makeAllocator
+  makes the allocator each container rebinds
+
+\param testName
+  the name printed with the results
+******************************************************************************/
+template <class MakeAllocator>
+void NodeContainerRun(MakeAllocator makeAllocator, const std::string& testName)
+{
+  using Allocator = decltype(makeAllocator());
+  using IntAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<int>;
+  using PairAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const int, int>>;
+
+  const int keyCount = 200000;
+  const int rounds = 5;
+
+  auto startTime = GetTime();
+
+  // for all rounds
+  for (int round = 0; round < rounds; ++round)
+  {
+    std::list<int, IntAllocator> list{IntAllocator(makeAllocator())};
+    std::map<int, int, std::less<int>, PairAllocator> map{PairAllocator(makeAllocator())};
+    std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, PairAllocator> hashMap{PairAllocator(makeAllocator())};
+
+    // for all keys
+    for (int i = 0; i < keyCount; ++i)
+    {
+      list.push_back(i);
+      map.emplace(i, i);
+      hashMap.emplace(i, i);
+
+      // if an older element should be erased
+      if (i % 2 == 1)
+      {
+        list.pop_front();
+        map.erase(i / 2);
+        hashMap.erase(i / 2);
+      }
+    }
+  }
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+
+  std::cout << testName << ": " << diff.count() * 1e9 / (rounds * keyCount * 3) << " ns per insert and half erase" << std::endl;
+}
+
+/*!****************************************************************************
+\brief
+  Compares node containers on std::allocator, on MemoryAllocator and on a
+  MemoryAllocator with a node pool
+******************************************************************************/
+void NodeContainerBenchmark(void)
+{
+  NodeContainerRun([]() { return std::allocator<int>(); }, "std::allocator nodes");
+
+  NodeContainerRun([]() { return MemoryAllocator<int>(); }, "MemoryAllocator nodes");
+
+  NodeContainerRun([]() { return MemoryAllocator<int>(0); }, "MemoryAllocator heap nodes");
+
+  NodeContainerRun([]() { return MemoryAllocator<int>(MEMORY_ANY_HEAP, true); }, "MemoryAllocator node pools");
+}
+
+/*!****************************************************************************
+\brief
+  Allocates the records of a message together, writes them and frees them
+  together, either with one call per record or with AllocBatch and
+  DeleteBatch
+
+\param size
+  the size of each record
+
+\param batched
+  true to use the batch calls, else false
+******************************************************************************/
+void BatchRun(size_t size, bool batched)
+{
+  const size_t recordCount = 64;
+  const size_t messages = 200000;
+
+  void* records[recordCount];
+
+  auto startTime = GetTime();
+
+  // for all messages
+  for (size_t message = 0; message < messages; ++message)
+  {
+    // if the records are allocated together
+    if (batched)
+    {
+      AllocBatch(size, recordCount, records);
+    }
+    else
+    {
+      // for all records
+      for (size_t i = 0; i < recordCount; ++i)
+      {
+        records[i] = Alloc(size);
+      }
+    }
+
+    // for all records
+    for (size_t i = 0; i < recordCount; ++i)
+    {
+      *(size_t*)(records[i]) = message + i;
+    }
+
+    // if the records are freed together
+    if (batched)
+    {
+      DeleteBatch(records, recordCount);
+    }
+    else
+    {
+      // for all records
+      for (size_t i = 0; i < recordCount; ++i)
+      {
+        Delete(records[i]);
+      }
+    }
+  }
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+
+  std::cout << (batched ? "AllocBatch and DeleteBatch" : "Alloc and Delete") << " of " << size << ": "
+            << diff.count() * 1e9 / (messages * recordCount) << " ns per record" << std::endl;
+}
+
+/*!****************************************************************************
+\brief
+  Compares allocating and freeing the records of a message one at a time
+  against doing it in one batch, for records the slabs hold and records
+  that come from the bins
+******************************************************************************/
+void BatchBenchmark(void)
+{
+  BatchRun(48, false);
+  BatchRun(48, true);
+  BatchRun(512, false);
+  BatchRun(512, true);
+  BatchRun(2048, false);
+  BatchRun(2048, true);
+}
+
+/*!****************************************************************************
+\brief
+  Grows a block with Realloc, which extends it in place when it can
+
+\param ptr
+  the block to grow
+
+\param oldSize
+  the current size of the block
+
+\param newSize
+  the size the block should have
+
+\return
+  the grown block
+******************************************************************************/
+void* ManagerGrow(void* ptr, size_t /* oldSize */, size_t newSize)
+{
+  return Realloc(ptr, newSize);
+}
+
+void* MallocGrow(void* ptr, size_t /* oldSize */, size_t newSize)
+{
+  return realloc(ptr, newSize);
+}
+
+/*!****************************************************************************
+\brief
+  Grows a block the way it had to be done before Realloc, by allocating a new
+  block, copying and freeing the old one
+
+\param ptr
+  the block to grow
+
+\param oldSize
+  the current size of the block
+
+\param newSize
+  the size the block should have
+
+\return
+  the grown block
+******************************************************************************/
+void* CopyGrow(void* ptr, size_t oldSize, size_t newSize)
+{
+  void* memory = Alloc(newSize);
+
+  // if there was an old block
+  if (ptr)
+  {
+    memcpy(memory, ptr, oldSize);
+    Delete(ptr);
+  }
+
+  return memory;
+}
+
+/*!****************************************************************************
+\brief
+  Times two growth patterns with one way of growing blocks. String builders
+  grow by each small append and are interleaved so they get in each other's
+  way, vectors grow their capacity by half each time up to 8 MiB
+
+\param grow
+  the function used to grow a block, a NULL block is allocated
+
+\param destroy
+  the function used to free a block
+
+\param testName
+  the name printed with the results
+******************************************************************************/
+void GrowthRun(void* (*grow)(void*, size_t, size_t), void (*destroy)(void*), const std::string& testName)
+{
+  const int builderCount = 4;
+  const size_t builderSize = 64 * 1024;
+  const size_t vectorSize = 8 * 1024 * 1024;
+
+  std::mt19937 random(7);
+  std::uniform_int_distribution<size_t> appendSize(8, 64);
+
+  auto startTime = GetTime();
+
+  // for all rounds of string building
+  for (int round = 0; round < 50; ++round)
+  {
+    char* builders[builderCount] = {};
+    size_t sizes[builderCount] = {};
+
+    // while the last builder is not full
+    while (sizes[builderCount - 1] < builderSize)
+    {
+      // for all builders, one append each
+      for (int i = 0; i < builderCount; ++i)
+      {
+        size_t append = appendSize(random);
+
+        builders[i] = (char*)grow(builders[i], sizes[i], sizes[i] + append);
+        memset(builders[i] + sizes[i], 'a' + i, append);
+        sizes[i] += append;
+      }
+    }
+
+    // free every builder
+    for (char* builder : builders)
+    {
+      destroy(builder);
+    }
+  }
+
+  PrintTimeDiff(startTime, testName + " string builders");
+
+  startTime = GetTime();
+
+  // for all rounds of vector growth
+  for (int round = 0; round < 20; ++round)
+  {
+    size_t capacity = 64;
+    char* vector = (char*)grow(NULL, 0, capacity);
+
+    // while the vector has room to double
+    while (capacity < vectorSize)
+    {
+      size_t newCapacity = capacity + capacity / 2;
+
+      vector = (char*)grow(vector, capacity, newCapacity);
+      memset(vector + capacity, 1, newCapacity - capacity); // fill the new elements
+      capacity = newCapacity;
+    }
+
+    destroy(vector);
+  }
+
+  PrintTimeDiff(startTime, testName + " vector growth");
+}
+
+/*!****************************************************************************
+\brief
+  Compares growing blocks with Realloc against malloc's realloc and against
+  allocating, copying and freeing
+******************************************************************************/
+void GrowthBenchmark(void)
+{
+  GrowthRun(ManagerGrow, Delete, "Realloc");
+  GrowthRun(MallocGrow, free, "realloc");
+  GrowthRun(CopyGrow, Delete, "Alloc and copy");
+}
+
+/*!****************************************************************************
+\brief
+  Allocates and frees a spike of page sized blocks, then prints the resident
+  memory a few times while the program sits idle and once more after Trim
+
+\param background
+  true to purge from the background thread, false to leave the idle pages
+  to the passes run when blocks are freed
+
+\param testName
+  the name printed with the results
+******************************************************************************/
+void DecayRun(bool background, const std::string& testName)
+{
+  const size_t spikeBytes = 128 * 1024 * 1024;
+
+  std::mt19937 random(11);
+  std::uniform_int_distribution<size_t> blockSize(2048, 8192);
+  std::vector<void*> blocks;
+  size_t total = 0;
+
+  MemoryManagerBackgroundPurge(background);
+  Trim(0);  // start without the free pages earlier benchmarks left resident
+
+  size_t startRSS = CurrentRSS();
+
+  // while the spike is not big enough
+  while (total < spikeBytes)
+  {
+    size_t size = blockSize(random);
+    void* block = Alloc(size);
+
+    memset(block, 1, size); // touch the block so it is resident
+    blocks.push_back(block);
+    total += size;
+  }
+
+  std::cout << testName << " spike: " << (CurrentRSS() - startRSS) / 1024 << " MiB resident" << std::endl;
+
+  // free the whole spike
+  for (void* block : blocks)
+  {
+    Delete(block);
+  }
+
+  blocks.clear();
+  blocks.shrink_to_fit();
+
+  auto startTime = GetTime();
+
+  // for all samples while idle
+  for (int sample = 1; sample <= 6; ++sample)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+    // one small free so the passes run on free have a chance too
+    Delete(Alloc(4096));
+
+    std::chrono::duration<double> idle = GetTime() - startTime;
+    size_t rss = CurrentRSS();
+
+    std::cout << testName << " idle " << idle.count() << " s: " << (rss > startRSS ? rss - startRSS : 0) / 1024 << " MiB resident" << std::endl;
+  }
+
+  size_t trimmed = Trim(0);
+  size_t rss = CurrentRSS();
+
+  std::cout << testName << " after Trim (" << trimmed / 1024 / 1024 << " MiB given back): " << (rss > startRSS ? rss - startRSS : 0) / 1024 << " MiB resident" << std::endl;
+
+  MemoryManagerBackgroundPurge(false);
+}
+
+/*!****************************************************************************
+\brief
+  Compares the resident memory left behind by a spike with pages that never
+  decay, that decay on free and that decay in the background
+******************************************************************************/
+void DecayBenchmark(void)
+{
+  MemoryManagerDecay(MEMORY_DECAY_NEVER);
+  DecayRun(false, "No decay");
+
+  MemoryManagerDecay(500);
+  DecayRun(false, "Decay on free");
+  DecayRun(true, "Background decay");
+
+  MemoryManagerDecay(10 * 1000);
+}
+
+/*!****************************************************************************
+\brief
+  Initializes the manager with some settings, then keeps a live set of blocks
+  of random sizes and replaces a random one many times. Prints the throughput
+  and the memory made resident by the work
+
+\param config
+  the settings to initialize the manager with
+******************************************************************************/
+void ConfigWork(const MemoryConfig& config)
+{
+  const size_t liveCount = 20000;
+  const int operations = 2000000;
+
+  std::mt19937 random(13);
+  std::uniform_int_distribution<int> sizeShift(6, 15);  // 64 bytes up to 32 KiB, as many small blocks as big ones
+  std::uniform_int_distribution<size_t> slot(0, liveCount - 1);
+  std::vector<void*> blocks(liveCount, nullptr);
+
+  size_t startRSS = CurrentRSS();
+
+  MemoryManagerInit(config);
+
+  auto startTime = GetTime();
+
+  // for all replacements
+  for (int i = 0; i < operations; ++i)
+  {
+    size_t index = slot(random);
+    size_t size = (size_t(1) << sizeShift(random)) + (random() & 63);
+
+    // if the slot holds a block
+    if (blocks[index])
+    {
+      Delete(blocks[index]);
+    }
+
+    blocks[index] = Alloc(size);
+
+    // for all system pages the block covers
+    for (size_t offset = 0; offset < size; offset += 4096)
+    {
+      ((char*)(blocks[index]))[offset] = 1; // touch the page so it is resident
+    }
+  }
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+  size_t rss = CurrentRSS();
+
+  // free every block
+  for (void* block : blocks)
+  {
+    Delete(block);
+  }
+
+  std::cout << "page " << config.pageSize / 1024 << " KiB, growth " << config.pageGrowth << "%, large "
+            << config.largeThreshold / 1024 << " KiB: " << operations / diff.count() / 1e6 << " M ops/sec, "
+            << (rss > startRSS ? rss - startRSS : 0) / 1024 << " MiB resident" << std::endl;
+}
+
+/*!****************************************************************************
+\brief
+  Runs the sweep workload with one set of settings. On Linux the work runs in
+  a child process so every run starts with a fresh manager, elsewhere the
+  runs share one and later ones reuse the pages of earlier ones
+
+\param pageSize
+  the bytes in a page
+
+\param pageGrowth
+  the percent of its pages an arena adds when it runs out
+
+\param largeThreshold
+  the smallest block that gets a mapping of its own
+******************************************************************************/
+void ConfigRun(size_t pageSize, size_t pageGrowth, size_t largeThreshold)
+{
+  MemoryConfig config;
+
+  MemoryManagerGetConfig(config);
+  config.pageSize = pageSize;
+  config.initialPages = 0;
+  config.pageGrowth = pageGrowth;
+  config.largeThreshold = largeThreshold;
+
+#if defined(__linux__)
+  std::cout.flush();
+
+  pid_t child = fork();
+
+  // if this is the child process
+  if (child == 0)
+  {
+    ConfigWork(config);
+    std::cout.flush();
+    _exit(0);
+  }
+
+  // if the child was started
+  if (child > 0)
+  {
+    waitpid(child, NULL, 0);
+  }
+#else
+  ConfigWork(config);
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Sweeps page size, page growth and the large threshold over one workload to
+  show how each trades throughput against resident memory
+******************************************************************************/
+void ConfigSweepBenchmark(void)
+{
+  MemoryConfig defaults;
+
+  MemoryManagerGetConfig(defaults);
+
+  // for all page sizes from one granule up to 256 KiB
+  for (size_t pageSize = 4 * 1024; pageSize <= 256 * 1024; pageSize *= 4)
+  {
+    ConfigRun(pageSize, 0, defaults.largeThreshold);
+  }
+
+  // for all page growth rates
+  for (size_t pageGrowth = 25; pageGrowth <= 100; pageGrowth *= 2)
+  {
+    ConfigRun(16 * 1024, pageGrowth, defaults.largeThreshold);
+  }
+
+  // for all large thresholds, down to blocks that barely fit in a page
+  for (size_t largeThreshold = 8 * 1024; largeThreshold <= 256 * 1024; largeThreshold *= 4)
+  {
+    ConfigRun(16 * 1024, 0, largeThreshold);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Times the paths the statistics counters sit on, the cached small block
+  path and the arena path, then times gathering the statistics and prints
+  them. Compare with a build from before the counters to see their cost
+******************************************************************************/
+void StatsBenchmark(void)
+{
+  const int pairs = 20000000;
+  const int arenaPairs = 2000000;
+
+  auto startTime = GetTime();
+
+  // for all cached pairs
+  for (int i = 0; i < pairs; ++i)
+  {
+    void* block = Alloc(64);
+
+    *(volatile char*)(block) = 0; // keep the pair from being optimized away
+    Delete(block);
+  }
+
+  std::chrono::duration<double> diff = GetTime() - startTime;
+
+  std::cout << "Cached Alloc and Delete: " << diff.count() * 1e9 / pairs << " ns per pair" << std::endl;
+
+  startTime = GetTime();
+
+  // for all arena pairs
+  for (int i = 0; i < arenaPairs; ++i)
+  {
+    void* block = Alloc(4096);
+
+    *(volatile char*)(block) = 0;
+    Delete(block);
+  }
+
+  diff = GetTime() - startTime;
+
+  std::cout << "Arena Alloc and Delete: " << diff.count() * 1e9 / arenaPairs << " ns per pair" << std::endl;
+
+  MemoryStats stats;
+
+  startTime = GetTime();
+  GetStats(stats);
+  diff = GetTime() - startTime;
+
+  std::cout << "GetStats: " << diff.count() * 1e6 << " us" << std::endl;
+
+  DumpStats(stdout, MEMORY_STATS_TEXT);
+  DumpStats(stdout, MEMORY_STATS_JSON);
+}
@@ -15,6 +15,7 @@
 //-----------------------------------------------------------------------------
 
 #include "MemoryAllocated.h"
+#include <stdint.h>
 
 //-----------------------------------------------------------------------------
 // Private Consts
@@ -48,6 +49,165 @@ MemoryAllocated::MemoryAllocated(size_t size) :
 {
 }
 
+/*!****************************************************************************
+\brief
+  Gets the header in front of a given piece of user memory
+
+\param memory
+  the memory given to the user
+
+\return
+  the header of the block
+******************************************************************************/
+MemoryAllocated* MemoryAllocated::FromMemory(void* memory)
+{
+  return (MemoryAllocated*)((uintptr_t)(memory) - sizeof(MemoryAllocated));
+}
+
+/*!****************************************************************************
+\brief
+  Gets the user memory behind the header
+
+\return
+  the memory given to the user
+******************************************************************************/
+void* MemoryAllocated::Memory(void)
+{
+  return (void*)((uintptr_t)(this) + sizeof(MemoryAllocated));
+}
+
+size_t MemoryAllocated::Size(void) const
+{
+  return size & ~(ALLOCATED_FLAGS | ALLOCATED_OWNER);
+}
+
+/*!****************************************************************************
+\brief
+  Changes the size of the block without touching its flags or owner
+
+\param newSize
+  the new size in bytes, must be a multiple of 8
+******************************************************************************/
+void MemoryAllocated::SetSize(size_t newSize)
+{
+  size = newSize | (size & (ALLOCATED_FLAGS | ALLOCATED_OWNER));
+}
+
+bool MemoryAllocated::IsFree(void) const
+{
+  return (size & ALLOCATED_FREE) != 0;
+}
+
+/*!****************************************************************************
+\brief
+  Marks the block as free or in use, a free block also writes its size into
+  its last bytes as a footer for the block after it
+
+\param free
+  true if the block is being freed, false if it is being used
+******************************************************************************/
+void MemoryAllocated::SetFree(bool free)
+{
+  // if the block is being freed
+  if (free)
+  {
+    size |= ALLOCATED_FREE;
+    *(size_t*)((uintptr_t)(this) + Size()) = Size(); // footer, the last size_t of the block
+  }
+  else
+  {
+    size &= ~ALLOCATED_FREE;
+  }
+}
+
+bool MemoryAllocated::IsPrevFree(void) const
+{
+  return (size & ALLOCATED_PREV_FREE) != 0;
+}
+
+void MemoryAllocated::SetPrevFree(bool prevFree)
+{
+  // if the block before this one is free
+  if (prevFree)
+  {
+    size |= ALLOCATED_PREV_FREE;
+  }
+  else
+  {
+    size &= ~ALLOCATED_PREV_FREE;
+  }
+}
+
+bool MemoryAllocated::IsLarge(void) const
+{
+  return (size & ALLOCATED_LARGE) != 0;
+}
+
+void MemoryAllocated::SetLarge(bool large)
+{
+  // if the block has a mapping of its own
+  if (large)
+  {
+    size |= ALLOCATED_LARGE;
+  }
+  else
+  {
+    size &= ~ALLOCATED_LARGE;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Gets the arena that handed out the block
+
+\return
+  the index of the owning arena
+******************************************************************************/
+unsigned int MemoryAllocated::Owner(void) const
+{
+  return (unsigned int)((size & ALLOCATED_OWNER) >> ALLOCATED_OWNER_SHIFT);
+}
+
+/*!****************************************************************************
+\brief
+  Records the arena that handed out the block, it must be freed back into the
+  same arena
+
+\param owner
+  the index of the owning arena
+******************************************************************************/
+void MemoryAllocated::SetOwner(unsigned int owner)
+{
+  size = (size & ~ALLOCATED_OWNER) | (((size_t)(owner) << ALLOCATED_OWNER_SHIFT) & ALLOCATED_OWNER);
+}
+
+/*!****************************************************************************
+\brief
+  Gets the header of the block directly after this one in memory
+
+\return
+  the header of the next block
+******************************************************************************/
+MemoryAllocated* MemoryAllocated::Next(void)
+{
+  return (MemoryAllocated*)((uintptr_t)(this) + sizeof(MemoryAllocated) + Size());
+}
+
+/*!****************************************************************************
+\brief
+  Gets the header of the block directly before this one in memory using its
+  footer, only valid while IsPrevFree is true
+
+\return
+  the header of the previous block
+******************************************************************************/
+MemoryAllocated* MemoryAllocated::Prev(void)
+{
+  size_t prevSize = *(size_t*)((uintptr_t)(this) - sizeof(size_t));
+
+  return (MemoryAllocated*)((uintptr_t)(this) - prevSize - sizeof(MemoryAllocated));
+}
+
 //-----------------------------------------------------------------------------
 // Private Class Functions
 //-----------------------------------------------------------------------------
@@ -1,4 +1,3 @@
-
 /*!****************************************************************************
 \file     MemoryBlock.h
 \author   Kenny Mecham
@@ -17,6 +16,9 @@
 // Include Files
 //-----------------------------------------------------------------------------
 
+#include <stddef.h>
+#include <stdint.h>
+
 //-----------------------------------------------------------------------------
 // Forward References
 //-----------------------------------------------------------------------------
@@ -25,6 +27,22 @@
 // Public Consts
 //-----------------------------------------------------------------------------
 
+const size_t ALLOCATED_FREE = 0x1;        //!< set while the block is in a free bin
+const size_t ALLOCATED_PREV_FREE = 0x2;   //!< set while the block before this one in memory is free
+const size_t ALLOCATED_LARGE = 0x4;       //!< set when the block has a system mapping of its own instead of living in a page
+const size_t ALLOCATED_FLAGS = 0x7;       //!< the low bits of the size that hold flags
+
+#if SIZE_MAX > 0xFFFFFFFF
+const size_t ALLOCATED_OWNER_SHIFT = 56;  //!< the top byte of the size holds the arena that owns the block
+const size_t ALLOCATED_OWNER = size_t(0xFF) << ALLOCATED_OWNER_SHIFT; //!< the bits of the size that hold the owner
+#else
+const size_t ALLOCATED_OWNER_SHIFT = 0;   //!< 32 bit sizes have no spare high bits, every block belongs to arena 0
+const size_t ALLOCATED_OWNER = 0;         //!< the bits of the size that hold the owner
+#endif
+
+//! the smallest block that can be freed, it has to hold two free list links and a footer
+const size_t MIN_BLOCK_SIZE = 2 * sizeof(void*) + sizeof(size_t);
+
 //-----------------------------------------------------------------------------
 // Public Variables
 //-----------------------------------------------------------------------------
@@ -37,7 +55,9 @@
 // Public Classes
 //-----------------------------------------------------------------------------
 
-//! Keeps track of all data for a given chunck of memory
+//! Keeps track of all data for a given chunck of memory, sits directly in
+//! front of the memory given to the user. Free blocks also copy their size
+//! into their last bytes so the block after them can find their header
 class MemoryAllocated
 {
   public:
@@ -45,5 +65,26 @@ class MemoryAllocated
     MemoryAllocated(void) = default;
     MemoryAllocated(size_t size);
 
-    size_t size;     //!< the amount of memory the user has
+    static MemoryAllocated* FromMemory(void* memory);
+    void* Memory(void);
+
+    size_t Size(void) const;
+    void SetSize(size_t size);
+
+    bool IsFree(void) const;
+    void SetFree(bool free);
+
+    bool IsPrevFree(void) const;
+    void SetPrevFree(bool prevFree);
+
+    bool IsLarge(void) const;
+    void SetLarge(bool large);
+
+    unsigned int Owner(void) const;
+    void SetOwner(unsigned int owner);
+
+    MemoryAllocated* Next(void);
+    MemoryAllocated* Prev(void);
+
+    size_t size;     //!< the amount of memory the user has, the low bits hold flags and the top byte the owner
 };
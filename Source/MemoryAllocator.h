@@ -6,8 +6,10 @@
 \date     06-06-2020
 
 \brief
-  A custom Memory Allocator used in the Memory Manager so that operator new
-  can be overloaded while simultaneously using the STL
+  The STL allocators of the Memory Manager. MemoryAllocator sends containers
+  to the manager, optionally to one of its heaps and with a node pool of its
+  own. MemoryPageAllocator maps whole pages for the manager's own tables, so
+  they live in manager memory without going back through operator new
 
 ******************************************************************************/
 
@@ -17,9 +19,11 @@
 // Include Files
 //-----------------------------------------------------------------------------
 
-#include <stdlib.h>
+#include "MemoryManager.h"
+#include "MemoryNodePool.h"
 #include <stddef.h>
 #include <limits>
+#include <type_traits>
 #include <utility>
 #include <new>
 
@@ -31,6 +35,8 @@
 // Public Consts
 //-----------------------------------------------------------------------------
 
+const unsigned int MEMORY_ANY_HEAP = ~0u; //!< allocate through the thread cache instead of one given heap
+
 //-----------------------------------------------------------------------------
 // Public Variables
 //-----------------------------------------------------------------------------
@@ -43,9 +49,18 @@
 // Public Classes
 //-----------------------------------------------------------------------------
 
+//! Allocates for a container from the manager. A default allocator goes
+//! through the thread cache like Alloc, one made with a heap index stays in
+//! that arena of the manager. Asking for a node pool gives the allocator and
+//! every copy or rebind of it a MemoryNodePool, single objects of the size of
+//! the container's nodes then come from the pool. A copy of the container
+//! gets a pool of its own, a pool is never shared by two containers
 template <class T>
 class MemoryAllocator
 {
+  template <class U>
+  friend class MemoryAllocator;
+
 public:
   using value_type = T;
   using pointer = T*;
@@ -55,9 +70,89 @@ public:
   using const_void_pointer = void const*;
   using size_type = size_t;
   using difference_type = ptrdiff_t;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  MemoryAllocator(void) : mHeap(MEMORY_ANY_HEAP), mPool(NULL) {}
+
+  /*!**************************************************************************
+  \brief
+    Makes an allocator bound to a heap of the manager
+
+  \param heap
+    the index of the arena to allocate from, less than
+    MemoryManagerArenaCount(), or MEMORY_ANY_HEAP for the thread cache
+
+  \param nodePool
+    true to give the allocator a node pool of its own
+  ****************************************************************************/
+  explicit MemoryAllocator(unsigned int heap, bool nodePool = false) :
+                           mHeap(heap),
+                           mPool(nodePool ? new MemoryNodePool : NULL)
+  {
+  }
+
+  MemoryAllocator(const MemoryAllocator& other) : mHeap(other.mHeap), mPool(other.mPool)
+  {
+    // if the node pool is shared with the copy
+    if (mPool)
+    {
+      mPool->AddRef();
+    }
+  }
+
+  template <class U>
+  MemoryAllocator(const MemoryAllocator<U>& other) : mHeap(other.mHeap), mPool(other.mPool)
+  {
+    // if the node pool is shared with the copy
+    if (mPool)
+    {
+      mPool->AddRef();
+    }
+  }
+
+  ~MemoryAllocator(void)
+  {
+    // if the allocator shares a node pool
+    if (mPool)
+    {
+      mPool->Release();
+    }
+  }
+
+  MemoryAllocator& operator=(const MemoryAllocator& rhs)
+  {
+    // if the node pool is shared with rhs
+    if (rhs.mPool)
+    {
+      rhs.mPool->AddRef();
+    }
+
+    // if the allocator shared a node pool before
+    if (mPool)
+    {
+      mPool->Release();
+    }
+
+    mHeap = rhs.mHeap;
+    mPool = rhs.mPool;
+
+    return *this;
+  }
 
-  MemoryAllocator(void) = default;
-  ~MemoryAllocator(void) = default;
+  /*!**************************************************************************
+  \brief
+    Makes the allocator for a copy of a container, bound to the same heap
+    but with a node pool of its own if this one has a pool
+
+  \return
+    the allocator the copy uses
+  ****************************************************************************/
+  MemoryAllocator select_on_container_copy_construction(void) const
+  {
+    return MemoryAllocator(mHeap, mPool != NULL);
+  }
 
   template <class U>
   struct rebind
@@ -65,12 +160,9 @@ public:
     using other = MemoryAllocator<U>;
   };
 
-  template <class U>
-  MemoryAllocator(const MemoryAllocator<U>& other) {}
-
   pointer allocate(const size_type numObjects) const
   {
-    if ((numObjects * sizeof(T)) > static_cast<size_type>(-1))
+    if (numObjects > max_size())
     {
       throw std::bad_alloc();
     }
@@ -79,14 +171,21 @@ public:
       return NULL;
     }
 
-    pointer temp = static_cast<pointer>(malloc(sizeof(T) * numObjects));
+    // if the object is a node the pool holds
+    if (numObjects == 1 && FromPool())
+    {
+      return static_cast<pointer>(mPool->Allocate(sizeof(T)));
+    }
+
+    size_type size = sizeof(T) * numObjects;
+    void* temp = (mHeap == MEMORY_ANY_HEAP) ? AllocAligned(size, alignof(T)) : MemoryManagerHeapAlloc(mHeap, size, alignof(T));
 
     if (temp == NULL)
     {
       throw std::bad_alloc();
     }
 
-    return temp;
+    return static_cast<pointer>(temp);
   }
 
   template <class U>
@@ -96,14 +195,26 @@ public:
     return allocate(numObjects);
   }
 
-  void deallocate(pointer ptr, size_type numObjects = 0) const
+  void deallocate(pointer ptr, size_type numObjects) const
   {
-    free(ptr);
+    // if the object is a node the pool holds
+    if (numObjects == 1 && FromPool())
+    {
+      mPool->Destroy(ptr);
+    }
+    else if (mHeap == MEMORY_ANY_HEAP)
+    {
+      Delete(ptr, sizeof(T) * numObjects);
+    }
+    else
+    {
+      MemoryManagerHeapDelete(ptr);
+    }
   }
 
   size_type max_size() const
   {
-    return (static_cast<size_type>(-1) / sizeof(size_type));
+    return (static_cast<size_type>(-1) / sizeof(T));
   }
 
   template <class... Args>
@@ -119,9 +230,84 @@ public:
     ptr->~T();
   }
 
-  bool operator==(const MemoryAllocator& rhs) const
+  template <class U>
+  bool operator==(const MemoryAllocator<U>& rhs) const
+  {
+    return mHeap == rhs.mHeap && mPool == rhs.mPool;
+  }
+
+  template <class U>
+  bool operator!=(const MemoryAllocator<U>& rhs) const
+  {
+    return !(*this == rhs);
+  }
+
+private:
+
+  unsigned int mHeap;     //!< the arena allocations come from, MEMORY_ANY_HEAP for the thread cache
+  MemoryNodePool* mPool;  //!< the node pool shared by every copy, NULL for none
+
+  /*!**************************************************************************
+  \brief
+    Checks whether single objects of T come from the node pool
+
+  \return
+    true if there is a pool and it holds objects the size of T, else false
+  ****************************************************************************/
+  bool FromPool(void) const
+  {
+    return mPool && alignof(T) <= NODE_POOL_ALIGNMENT && mPool->Holds(sizeof(T));
+  }
+};
+
+//! Allocates whole pages straight from the page source for the manager's own
+//! tables. It never takes an arena lock or goes through operator new, so it
+//! is safe to use while the manager is in the middle of an allocation
+template <class T>
+class MemoryPageAllocator
+{
+public:
+  using value_type = T;
+
+  MemoryPageAllocator(void) = default;
+  ~MemoryPageAllocator(void) = default;
+
+  template <class U>
+  MemoryPageAllocator(const MemoryPageAllocator<U>& other) {}
+
+  T* allocate(const size_t numObjects) const
+  {
+    // if the size would overflow
+    if (numObjects > static_cast<size_t>(-1) / sizeof(T))
+    {
+      throw std::bad_alloc();
+    }
+
+    void* temp = MemoryManagerMapPages(sizeof(T) * numObjects);
+
+    // if the system is out of memory
+    if (temp == NULL)
+    {
+      throw std::bad_alloc();
+    }
+
+    return static_cast<T*>(temp);
+  }
+
+  void deallocate(T* ptr, size_t numObjects) const
+  {
+    MemoryManagerUnmapPages(ptr, sizeof(T) * numObjects);
+  }
+
+  template <class U>
+  bool operator==(const MemoryPageAllocator<U>& /* rhs */) const
   {
     return true;
   }
 
+  template <class U>
+  bool operator!=(const MemoryPageAllocator<U>& /* rhs */) const
+  {
+    return false;
+  }
 };
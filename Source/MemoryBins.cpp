@@ -0,0 +1,492 @@
+/*!****************************************************************************
+\file     MemoryBins.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the size class table and the implementation of all MemoryBins class
+  functions. The bins form a two level index like TLSF, the first level picks
+  the power of two a size falls in and the second level picks one of its
+  BIN_GROUP_SIZE linear steps, each level has a bitmap of non empty bins
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryBins.h"
+#include "MemoryAllocated.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+//! The size in bytes of every size class, filled in at compile time
+struct BinTable
+{
+  size_t sizes[BIN_COUNT];  //!< the size of each class, smallest first
+};
+
+//! The links stored in the user memory of a free block
+struct FreeLinks
+{
+  FreeLinks* next;  //!< the next block in the same bin
+  FreeLinks* prev;  //!< the previous block in the same bin
+};
+
+//-----------------------------------------------------------------------------
+// Private Function Declerations
+//-----------------------------------------------------------------------------
+
+static unsigned int FloorLog2(uint64_t value);
+static unsigned int FindFirstSet(uint32_t value);
+
+/*!****************************************************************************
+\brief
+  Generates the size class table. The first group of classes is spaced
+  linearly by BIN_ALIGNMENT, every group after that covers one power of two
+  split into BIN_GROUP_SIZE even steps (40, 48, 56, 64, 80, 96, 112, 128...)
+
+\return
+  the filled in table
+******************************************************************************/
+static constexpr BinTable GenerateBinTable(void)
+{
+  BinTable table = {};
+
+  // for all size classes
+  for (size_t i = 0; i < BIN_COUNT; ++i)
+  {
+    size_t group = i / BIN_GROUP_SIZE;
+    size_t step = i % BIN_GROUP_SIZE + 1;
+
+    // if this is the linear group
+    if (group == 0)
+    {
+      table.sizes[i] = step * BIN_ALIGNMENT;
+    }
+    else
+    {
+      table.sizes[i] = (size_t(16) << group) + step * (size_t(4) << group);
+    }
+  }
+
+  return table;
+}
+
+static constexpr BinTable BIN_TABLE = GenerateBinTable();
+
+static_assert(BIN_TABLE.sizes[0] == 8, "smallest size class must hold a free list link");
+static_assert(BIN_TABLE.sizes[7] == 64, "size classes must double every BIN_GROUP_SIZE classes");
+static_assert(BIN_TABLE.sizes[BIN_COUNT - 1] == 1048576, "largest size class must be 1 MiB");
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryBins
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+MemoryBins::MemoryBins(void) :
+                       mBins(),
+                       mGroupBitmap(0),
+                       mClassBitmaps()
+{
+}
+
+/*!****************************************************************************
+\brief
+  Gets the smallest size class that can hold the given size
+
+\param size
+  the number of bytes requested
+
+\return
+  the index of the size class, BIN_COUNT if the size is larger than every class
+******************************************************************************/
+size_t MemoryBins::ClassIndex(size_t size)
+{
+  // if size fits in the smallest class
+  if (size <= BIN_ALIGNMENT)
+  {
+    return 0;
+  }
+
+  return FloorIndex(size - 1) + 1;  // the class above the largest class smaller than size
+}
+
+/*!****************************************************************************
+\brief
+  Gets the largest size class that is not bigger than the given size, this is
+  the bin a free block of that size belongs in
+
+\param size
+  the size of the block in bytes, must be at least BIN_ALIGNMENT
+
+\return
+  the index of the size class
+******************************************************************************/
+size_t MemoryBins::FloorIndex(size_t size)
+{
+  // if size is in the linear group
+  if (size < BIN_GROUP_SIZE * BIN_ALIGNMENT)
+  {
+    return size / BIN_ALIGNMENT - 1;
+  }
+
+  size_t power = FloorLog2(size);
+  size_t index = BIN_GROUP_SIZE * (power - 4) + ((size >> (power - 2)) & (BIN_GROUP_SIZE - 1)) - 1;
+
+  // if size is past the largest class
+  if (index >= BIN_COUNT)
+  {
+    return BIN_COUNT - 1;
+  }
+
+  return index;
+}
+
+/*!****************************************************************************
+\brief
+  Gets the size in bytes of a size class
+
+\param index
+  the index of the size class
+
+\return
+  the size of the class in bytes
+******************************************************************************/
+size_t MemoryBins::ClassSize(size_t index)
+{
+  return BIN_TABLE.sizes[index];
+}
+
+/*!****************************************************************************
+\brief
+  Adds a free block to the bin of the largest class that fits inside of it
+
+\param block
+  the user memory of the block, it must be able to hold two pointers
+
+\param size
+  the size of the block in bytes
+******************************************************************************/
+void MemoryBins::Push(void* block, size_t size)
+{
+  size_t index = FloorIndex(size);
+  FreeLinks* links = (FreeLinks*)block;
+  FreeLinks* head = (FreeLinks*)mBins[index];
+
+  links->next = head; // link block in front of the old head
+  links->prev = NULL;
+
+    // if the bin already had blocks
+  if (head)
+  {
+    head->prev = links;
+  }
+
+  mBins[index] = block;
+  mGroupBitmap |= uint32_t(1) << (index / BIN_GROUP_SIZE);
+  mClassBitmaps[index / BIN_GROUP_SIZE] |= uint32_t(1) << (index % BIN_GROUP_SIZE);
+}
+
+/*!****************************************************************************
+\brief
+  Removes a block from the given bin
+
+\param index
+  the size class to remove a block from
+
+\return
+  a block at least ClassSize(index) bytes large, NULL if the bin is empty
+******************************************************************************/
+void* MemoryBins::Pop(size_t index)
+{
+  // if the bin has no blocks
+  if (Empty(index))
+  {
+    return NULL;
+  }
+
+  void* block = mBins[index];
+  Remove(block, index);
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Unlinks a block from the middle of its bin, used when a free block is
+  merged into a neighbour
+
+\param block
+  the user memory of the block
+
+\param index
+  the size class the block was pushed into, FloorIndex(size)
+******************************************************************************/
+void MemoryBins::Remove(void* block, size_t index)
+{
+  FreeLinks* links = (FreeLinks*)block;
+
+  // if the block is not the head of its bin
+  if (links->prev)
+  {
+    links->prev->next = links->next;
+  }
+  else
+  {
+    mBins[index] = links->next;
+  }
+
+  // if the block is not the tail of its bin
+  if (links->next)
+  {
+    links->next->prev = links->prev;
+  }
+
+  // if that was the last block
+  if (mBins[index] == NULL)
+  {
+    size_t group = index / BIN_GROUP_SIZE;
+
+    mClassBitmaps[group] &= ~(uint32_t(1) << (index % BIN_GROUP_SIZE));
+
+      // if that was the last non empty bin in the group
+    if (mClassBitmaps[group] == 0)
+    {
+      mGroupBitmap &= ~(uint32_t(1) << group);
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Removes a block from the smallest non empty bin whose blocks are all at
+  least the given size. The search is two bitmap scans, one inside the group
+  of the size and one over the groups above it
+
+\param size
+  the number of bytes needed
+
+\return
+  a block at least size bytes large, NULL if none was found
+******************************************************************************/
+void* MemoryBins::PopFit(size_t size)
+{
+  size_t index = ClassIndex(size);
+
+  // if the size is bigger than every class
+  if (index >= BIN_COUNT)
+  {
+    return PopFirstFit(size);
+  }
+
+  size_t group = index / BIN_GROUP_SIZE;
+  uint32_t classes = mClassBitmaps[group] & (~uint32_t(0) << (index % BIN_GROUP_SIZE));
+
+  // if no bin in this group is big enough
+  if (classes == 0)
+  {
+    uint32_t groups = (group + 1 < BIN_GROUP_COUNT) ? (mGroupBitmap & (~uint32_t(0) << (group + 1))) : 0;
+
+    // if no group above has any blocks
+    if (groups == 0)
+    {
+      return NULL;
+    }
+
+    group = FindFirstSet(groups);
+    classes = mClassBitmaps[group];
+  }
+
+  return Pop(group * BIN_GROUP_SIZE + FindFirstSet(classes));
+}
+
+/*!****************************************************************************
+\brief
+  Removes a block from the largest bin that holds any blocks
+
+\return
+  the removed block, NULL if every bin is empty
+******************************************************************************/
+void* MemoryBins::PopLargest(void)
+{
+  // if every bin is empty
+  if (mGroupBitmap == 0)
+  {
+    return NULL;
+  }
+
+  size_t group = FloorLog2(mGroupBitmap);
+
+  return Pop(group * BIN_GROUP_SIZE + FloorLog2(mClassBitmaps[group]));
+}
+
+/*!****************************************************************************
+\brief
+  Checks the bitmap for whether a bin holds any blocks
+
+\param index
+  the size class to check
+
+\return
+  true if the bin has no blocks, else false
+******************************************************************************/
+bool MemoryBins::Empty(size_t index) const
+{
+  return (mClassBitmaps[index / BIN_GROUP_SIZE] & (uint32_t(1) << (index % BIN_GROUP_SIZE))) == 0;
+}
+
+/*!****************************************************************************
+\brief
+  Gets the first block of a bin, with Next it walks the bin for statistics
+
+\param index
+  the size class to walk
+
+\return
+  the memory of the first block, NULL if the bin is empty
+******************************************************************************/
+void* MemoryBins::First(size_t index) const
+{
+  return mBins[index];
+}
+
+/*!****************************************************************************
+\brief
+  Gets the block after a block in the same bin
+
+\param block
+  the memory of a block in a bin
+
+\return
+  the memory of the next block, NULL at the end of the bin
+******************************************************************************/
+void* MemoryBins::Next(void* block)
+{
+  return ((FreeLinks*)(block))->next;
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Removes the first block in the largest bin that can hold the given size,
+  used for sizes too big for any size class
+
+\param size
+  the number of bytes needed
+
+\return
+  a block at least size bytes large, NULL if none was found
+******************************************************************************/
+void* MemoryBins::PopFirstFit(size_t size)
+{
+  FreeLinks* links = (FreeLinks*)mBins[BIN_COUNT - 1];
+
+  // while there are blocks left in the bin
+  while (links)
+  {
+    // if this block is big enough
+    if (MemoryAllocated::FromMemory(links)->Size() >= size)
+    {
+      Remove(links, BIN_COUNT - 1);
+
+      return links;
+    }
+
+    links = links->next;
+  }
+
+  return NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Finds the index of the highest set bit
+
+\param value
+  the value to search, must not be 0
+
+\return
+  the index of the highest set bit
+******************************************************************************/
+static unsigned int FloorLog2(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+
+  // if the high half has a set bit
+  if (value >> 32)
+  {
+    _BitScanReverse(&index, (unsigned long)(value >> 32));
+    return index + 32;
+  }
+
+  _BitScanReverse(&index, (unsigned long)(value));
+  return index;
+#else
+  return 63 - __builtin_clzll(value);
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Finds the index of the lowest set bit
+
+\param value
+  the value to search, must not be 0
+
+\return
+  the index of the lowest set bit
+******************************************************************************/
+static unsigned int FindFirstSet(uint32_t value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
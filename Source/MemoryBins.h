@@ -0,0 +1,78 @@
+/*!****************************************************************************
+\file     MemoryBins.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the MemoryBins class, a table of segregated free lists indexed by
+  size class with a bitmap of the bins that currently hold blocks
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t BIN_COUNT = 64;        //!< number of size classes, one bit each in the bitmap
+const size_t BIN_GROUP_SIZE = 4;    //!< number of size classes per power of two
+const size_t BIN_GROUP_COUNT = BIN_COUNT / BIN_GROUP_SIZE; //!< number of powers of two the classes cover
+const size_t BIN_ALIGNMENT = 8;     //!< every size class is a multiple of this
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! Segregated free lists of blocks, one list per geometrically spaced size class,
+//! indexed in two levels so the best fitting bin is found in constant time
+class MemoryBins
+{
+  public:
+
+    MemoryBins(void);
+    ~MemoryBins(void) = default;
+
+    static size_t ClassIndex(size_t size);
+    static size_t FloorIndex(size_t size);
+    static size_t ClassSize(size_t index);
+
+    void Push(void* block, size_t size);
+    void* Pop(size_t index);
+    void Remove(void* block, size_t index);
+    void* PopFit(size_t size);
+    void* PopLargest(void);
+
+    bool Empty(size_t index) const;
+    void* First(size_t index) const;
+    static void* Next(void* block);
+
+  private:
+
+    void* mBins[BIN_COUNT];                   //!< head of the intrusive free list for each size class
+    uint32_t mGroupBitmap;                    //!< bit g is set when any bin in group g holds a block
+    uint32_t mClassBitmaps[BIN_GROUP_COUNT];  //!< bit s of entry g is set when bin g * BIN_GROUP_SIZE + s holds a block
+
+    void* PopFirstFit(size_t size);
+};
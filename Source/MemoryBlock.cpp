@@ -69,7 +69,7 @@ MemoryBlock::MemoryBlock(void* location,
                          mSize(size)
 {
   MemoryAllocated* temp = (MemoryAllocated*)((uintptr_t)(location) - sizeof(MemoryAllocated));
-  temp->size = mSize;
+  *temp = MemoryAllocated(mSize);
 }
 
 MemoryBlock::MemoryBlock(const MemoryBlock& block) : 
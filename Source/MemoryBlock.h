@@ -17,6 +17,8 @@
 // Include Files
 //-----------------------------------------------------------------------------
 
+#include <stddef.h>
+
 //-----------------------------------------------------------------------------
 // Forward References
 //-----------------------------------------------------------------------------
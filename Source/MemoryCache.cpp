@@ -0,0 +1,135 @@
+/*!****************************************************************************
+\file     MemoryCache.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all MemoryCache class functions
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryCache.h"
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryCache
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+MemoryCache::MemoryCache(void) :
+                         mLists(),
+                         mCounts()
+{
+}
+
+/*!****************************************************************************
+\brief
+  Takes a block out of a size class list
+
+\param index
+  the size class of the block
+
+\return
+  the block, NULL if the list is empty
+******************************************************************************/
+void* MemoryCache::Pop(size_t index)
+{
+  void* block = mLists[index];
+
+  // if the list has a block
+  if (block)
+  {
+    mLists[index] = *(void**)block;
+    --mCounts[index];
+  }
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Adds a block to a size class list
+
+\param index
+  the size class of the block, every block in the list must be at least
+  MemoryBins::ClassSize(index) bytes
+
+\param block
+  the user memory of the block
+******************************************************************************/
+void MemoryCache::Push(size_t index, void* block)
+{
+  *(void**)block = mLists[index];
+  mLists[index] = block;
+  ++mCounts[index];
+}
+
+bool MemoryCache::Empty(size_t index) const
+{
+  return mLists[index] == NULL;
+}
+
+/*!****************************************************************************
+\brief
+  Checks if a list holds enough blocks that a batch should go back to the
+  manager
+
+\param index
+  the size class to check
+
+\return
+  true if the list has two batches worth of blocks, else false
+******************************************************************************/
+bool MemoryCache::Full(size_t index) const
+{
+  return mCounts[index] >= 2 * CACHE_BATCH_SIZE;
+}
+
+/*!****************************************************************************
+\brief
+  Forgets every block in the cache without giving it back, for blocks whose
+  pages the manager has already released
+******************************************************************************/
+void MemoryCache::Clear(void)
+{
+  memset(mLists, 0, sizeof(mLists));
+  memset(mCounts, 0, sizeof(mCounts));
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
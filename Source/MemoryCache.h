@@ -0,0 +1,68 @@
+/*!****************************************************************************
+\file     MemoryCache.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the MemoryCache class, the per thread lists of small blocks that
+  sit in front of the shared manager
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t CACHE_MAX_SIZE = 1024;   //!< the largest block a cache holds
+const size_t CACHE_CLASS_COUNT = 24;  //!< the number of size classes up to CACHE_MAX_SIZE
+const size_t CACHE_BATCH_SIZE = 32;   //!< the number of blocks moved to or from the manager at once
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! A list of blocks per small size class, owned by a single thread so it is
+//! used without any locking. Blocks in a cache are still in use as far as the
+//! manager is concerned
+class MemoryCache
+{
+  public:
+
+    MemoryCache(void);
+    ~MemoryCache(void) = default;
+
+    void* Pop(size_t index);
+    void Push(size_t index, void* block);
+
+    bool Empty(size_t index) const;
+    bool Full(size_t index) const;
+
+    void Clear(void);
+
+  private:
+
+    void* mLists[CACHE_CLASS_COUNT];          //!< head of the intrusive list of blocks for each size class
+    unsigned int mCounts[CACHE_CLASS_COUNT];  //!< the number of blocks in each list
+};
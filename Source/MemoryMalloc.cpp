@@ -0,0 +1,490 @@
+/*!****************************************************************************
+\file     MemoryMalloc.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Replaces the C allocation functions with the manager when it is built into
+  a shared library, so it can be preloaded into programs that were never
+  built against it. Only built on Linux, see the MemoryManagerMalloc target.
+
+  The C library and the loader call malloc before the manager's static
+  initializers have run, and destructors that run after the arenas are gone
+  still call free. Those calls are served from a small static region that is
+  never given back, everything in between goes to the manager
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryManager.h"
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+//! The library is built with hidden visibility so the manager's own functions
+//! cannot clash with the program's, only the C functions below are exported
+#define MALLOC_EXPORT __attribute__((visibility("default")))
+
+const size_t BOOTSTRAP_SIZE = 1024 * 1024;  //!< the bytes handed out before the manager is ready, more than start-up needs
+const size_t BOOTSTRAP_ALIGNMENT = 16;      //!< the alignment malloc promises on 64 bit systems
+
+//-----------------------------------------------------------------------------
+// Private Function Declerations
+//-----------------------------------------------------------------------------
+
+bool RegisterForkHandlers(void);
+void* BootstrapAllocate(size_t size, size_t alignment);
+bool IsBootstrap(const void* ptr);
+size_t BootstrapSize(const void* ptr);
+void* MoveBlock(void* ptr, size_t size);
+size_t SystemPageSize(void);
+
+//-----------------------------------------------------------------------------
+// Private Variables
+//-----------------------------------------------------------------------------
+
+alignas(BOOTSTRAP_ALIGNMENT) char bootstrapMemory[BOOTSTRAP_SIZE];  //!< zeroed by the loader, so calloc can use it as is
+
+std::atomic<size_t> bootstrapUsed(0); //!< the bytes of bootstrapMemory handed out so far
+
+bool forkHandlers = RegisterForkHandlers(); //!< true once the arenas are locked around every fork
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+extern "C"
+{
+
+MALLOC_EXPORT void* malloc(size_t size) noexcept
+{
+  // if the manager is not ready yet or the program is exiting
+  if (!MemoryManagerReady())
+  {
+    return BootstrapAllocate(size, BOOTSTRAP_ALIGNMENT);
+  }
+
+  try
+  {
+    return Alloc(size);
+  }
+  catch (const std::bad_alloc&)
+  {
+    errno = ENOMEM;
+    return NULL;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Frees a block from any of the functions here. Blocks from the bootstrap
+  region and blocks of some other allocator are left alone, a program that
+  frees memory it got before this library was loaded keeps running
+
+\param ptr
+  the block to free, NULL does nothing
+******************************************************************************/
+MALLOC_EXPORT void free(void* ptr) noexcept
+{
+  // if the block is in the bootstrap region
+  if (ptr == NULL || IsBootstrap(ptr))
+  {
+    return;
+  }
+
+  TryDelete(ptr);
+}
+
+/*!****************************************************************************
+\brief
+  Allocates zeroed memory for an array, failing if the size overflows
+
+\param count
+  the number of elements
+
+\param size
+  the size of an element
+
+\return
+  the zeroed memory, NULL if there was not enough
+******************************************************************************/
+MALLOC_EXPORT void* calloc(size_t count, size_t size) noexcept
+{
+  size_t total = count * size;
+
+  // if the array is bigger than the address space
+  if (size && total / size != count)
+  {
+    errno = ENOMEM;
+    return NULL;
+  }
+
+  // if the manager is not ready yet, the region has never been written to
+  if (!MemoryManagerReady())
+  {
+    return BootstrapAllocate(total, BOOTSTRAP_ALIGNMENT);
+  }
+
+  void* block;
+
+  // Alloc is called instead of malloc so the compiler cannot turn the pair
+  // below back into a call to calloc
+  try
+  {
+    block = Alloc(total);
+  }
+  catch (const std::bad_alloc&)
+  {
+    errno = ENOMEM;
+    return NULL;
+  }
+
+  // if there is a block to clear
+  if (block)
+  {
+    memset(block, 0, total);
+  }
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Changes the size of a block with the semantics of C realloc. Blocks from
+  the bootstrap region are moved into the manager once it is ready
+
+\param ptr
+  the block to resize, NULL allocates a new block
+
+\param size
+  the new size in bytes, 0 frees the block
+
+\return
+  the resized block, NULL if size was 0 or there was not enough memory
+******************************************************************************/
+MALLOC_EXPORT void* realloc(void* ptr, size_t size) noexcept
+{
+  // if there is no block yet
+  if (ptr == NULL)
+  {
+    return malloc(size);
+  }
+
+  // if the block cannot be resized by the manager
+  if (IsBootstrap(ptr) || !MemoryManagerReady())
+  {
+    return MoveBlock(ptr, size);
+  }
+
+  // if the block came from another allocator, Realloc would hand it back to
+  // realloc and end up here again
+  if (!MemoryManagerOwns(ptr))
+  {
+    errno = ENOMEM;
+    return NULL;
+  }
+
+  try
+  {
+    void* block = Realloc(ptr, size);
+
+    // if the block could not grow
+    if (block == NULL && size)
+    {
+      errno = ENOMEM;
+    }
+
+    return block;
+  }
+  catch (const std::bad_alloc&)
+  {
+    errno = ENOMEM;
+    return NULL;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Allocates memory aligned to a given boundary. Like glibc, an alignment that
+  is not a power of two is rounded up to one
+
+\param alignment
+  the boundary the memory must start on
+
+\param size
+  the number of bytes to allocate
+
+\return
+  the aligned memory, NULL if there was not enough
+******************************************************************************/
+MALLOC_EXPORT void* memalign(size_t alignment, size_t size) noexcept
+{
+  size_t boundary = BOOTSTRAP_ALIGNMENT;
+
+  // for all powers of two below the alignment
+  while (boundary < alignment)
+  {
+    // if the alignment cannot be rounded up
+    if (boundary > SIZE_MAX / 2)
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+
+    boundary <<= 1;
+  }
+
+  // if the manager is not ready yet or the program is exiting
+  if (!MemoryManagerReady())
+  {
+    return BootstrapAllocate(size, boundary);
+  }
+
+  try
+  {
+    return AllocAligned(size, boundary);
+  }
+  catch (const std::bad_alloc&)
+  {
+    errno = ENOMEM;
+    return NULL;
+  }
+}
+
+MALLOC_EXPORT int posix_memalign(void** memptr, size_t alignment, size_t size) noexcept
+{
+  // if the manager is ready, it checks the alignment itself
+  if (MemoryManagerReady())
+  {
+    return PosixMemalign(memptr, alignment, size);
+  }
+
+  // if the alignment is not a power of two multiple of sizeof(void*)
+  if (alignment < sizeof(void*) || (alignment & (alignment - 1)))
+  {
+    return EINVAL;
+  }
+
+  void* block = BootstrapAllocate(size, alignment);
+
+  // if the region is used up
+  if (block == NULL)
+  {
+    return ENOMEM;
+  }
+
+  *memptr = block;
+
+  return 0;
+}
+
+MALLOC_EXPORT void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+  // if the alignment is not a power of two
+  if (alignment == 0 || (alignment & (alignment - 1)))
+  {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  return memalign(alignment, size);
+}
+
+MALLOC_EXPORT void* valloc(size_t size) noexcept
+{
+  return memalign(SystemPageSize(), size);
+}
+
+MALLOC_EXPORT void* pvalloc(size_t size) noexcept
+{
+  size_t page = SystemPageSize();
+
+  // if rounding up to a whole page would overflow
+  if (size > SIZE_MAX - page)
+  {
+    errno = ENOMEM;
+    return NULL;
+  }
+
+  return memalign(page, (size + page - 1) & ~(page - 1));
+}
+
+MALLOC_EXPORT size_t malloc_usable_size(void* ptr) noexcept
+{
+  // if there is no block
+  if (ptr == NULL)
+  {
+    return 0;
+  }
+
+  // if the block is in the bootstrap region
+  if (IsBootstrap(ptr))
+  {
+    return BootstrapSize(ptr);
+  }
+
+  return UsableSize(ptr);
+}
+
+}
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Makes a fork wait until no thread is inside an arena, a child copied while
+  an arena was locked would never be able to allocate
+
+\return
+  true if the handlers were registered
+******************************************************************************/
+bool RegisterForkHandlers(void)
+{
+  return pthread_atfork(MemoryManagerLock, MemoryManagerUnlock, MemoryManagerUnlock) == 0;
+}
+
+/*!****************************************************************************
+\brief
+  Hands out memory from the bootstrap region without locking. Every block is
+  preceded by its size, the region is never reused
+
+\param size
+  the number of bytes to allocate
+
+\param alignment
+  the power of two boundary the block must start on
+
+\return
+  the block, NULL if the region is used up
+******************************************************************************/
+void* BootstrapAllocate(size_t size, size_t alignment)
+{
+  // if the alignment is below the one every block gets anyway
+  if (alignment < BOOTSTRAP_ALIGNMENT)
+  {
+    alignment = BOOTSTRAP_ALIGNMENT;
+  }
+
+  size_t used = bootstrapUsed.load(std::memory_order_relaxed);
+  size_t start;
+  size_t end;
+
+  do
+  {
+    start = (used + sizeof(size_t) + alignment - 1) & ~(alignment - 1);
+    end = start + ((size + BOOTSTRAP_ALIGNMENT - 1) & ~(BOOTSTRAP_ALIGNMENT - 1));
+
+    // if the block does not fit in what is left of the region
+    if (start > BOOTSTRAP_SIZE || end > BOOTSTRAP_SIZE || end < start)
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+  } while (!bootstrapUsed.compare_exchange_weak(used, end, std::memory_order_relaxed));
+
+  char* block = bootstrapMemory + start;
+
+  *(size_t*)(block - sizeof(size_t)) = end - start;
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether a block came from the bootstrap region
+
+\param ptr
+  the block to check
+
+\return
+  true if the block is in the region, else false
+******************************************************************************/
+bool IsBootstrap(const void* ptr)
+{
+  const char* memory = (const char*)(ptr);
+
+  return memory >= bootstrapMemory && memory < bootstrapMemory + BOOTSTRAP_SIZE;
+}
+
+/*!****************************************************************************
+\brief
+  Reads the usable size of a block in the bootstrap region
+
+\param ptr
+  the block, it must be in the region
+
+\return
+  the bytes the block can hold
+******************************************************************************/
+size_t BootstrapSize(const void* ptr)
+{
+  return *(const size_t*)((const char*)(ptr) - sizeof(size_t));
+}
+
+/*!****************************************************************************
+\brief
+  Resizes a block the manager cannot resize in place by copying it to a new
+  block. The old block is only freed if it was the manager's and the manager
+  is still running
+
+\param ptr
+  the block to move
+
+\param size
+  the new size in bytes, 0 frees the block
+
+\return
+  the new block, NULL if size was 0 or there was not enough memory
+******************************************************************************/
+void* MoveBlock(void* ptr, size_t size)
+{
+  // if the block is only being freed
+  if (size == 0)
+  {
+    free(ptr);
+    return NULL;
+  }
+
+  void* block = malloc(size);
+
+  // if there was not enough memory, the old block is kept
+  if (block == NULL)
+  {
+    return NULL;
+  }
+
+  size_t oldSize = IsBootstrap(ptr) ? BootstrapSize(ptr) : UsableSize(ptr);
+
+  memcpy(block, ptr, oldSize < size ? oldSize : size);
+  free(ptr);
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Reads the size of a system page
+
+\return
+  the size of a page in bytes
+******************************************************************************/
+size_t SystemPageSize(void)
+{
+  return (size_t)(sysconf(_SC_PAGESIZE));
+}
@@ -18,30 +18,66 @@
 #include "MemoryManager.h"
 #include "MemoryBlock.h"
 #include "MemoryAllocated.h"
+#include "MemoryBins.h"
+#include "MemoryCache.h"
 #include "MemoryPage.h"
+#include "MemoryPageMap.h"
+#include "MemoryPageSource.h"
+#include "MemorySlab.h"
+#include "MemoryTrace.h"
+#include "MemoryProfile.h"
 #include "MemoryAllocator.h"
-#include <set>
-#include <unordered_map>
+#include <algorithm>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <new>
 #include <utility>
+#include <cerrno>
 #include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <pthread.h>
+#endif
 
 //-----------------------------------------------------------------------------
 // Private Consts
 //-----------------------------------------------------------------------------
 
-const size_t PAGE_SIZE = 16000;  //!< a page is 16000 bytes in size
+const size_t PAGE_SIZE = 4 * PAGE_ALIGNMENT;  //!< the bytes in a page by default, four granules with its header and fence
+
+const size_t INITIAL_PAGES = 20;  //!< the pages MemoryManagerInit gives the first arena by default
+
+const size_t PAGE_GROWTH = 0;     //!< the percent of its pages an arena adds at once by default, one page at a time
+
+const size_t GROWTH_MAX = 8 * 1024 * 1024; //!< the most bytes of pages an arena adds at once, however many it holds
 
-#define MANAGER_SIZE_TABLE std::unordered_multimap<size_t, MemoryBlock, std::hash<size_t>, std::equal_to<size_t>, MemoryAllocator<std::pair<const size_t, MemoryBlock> > >
+const size_t LARGE_THRESHOLD = 256 * 1024; //!< blocks this big or bigger get a system mapping of their own by default
 
-#define MANAGER_LOC_TABLE std::unordered_map<void*, MemoryBlock, std::hash<void*>, std::equal_to<void*>, MemoryAllocator<std::pair<const void*, MemoryBlock>>>
+const size_t DECAY_TIME = 10 * 1000;  //!< the milliseconds a whole free page stays resident by default before it is purged
+
+const size_t SLAB_RECLAIM_SCAN = 8;   //!< the most pages made from slabs checked for one that is wholly free before a new slab is mapped
+
+//! the most arenas that can be used, every arena index has to fit in the owner bits of a block
+const unsigned int ARENA_MAX = ALLOCATED_OWNER ? 64 : 1;
+
+static_assert(MEMORY_STATS_BIN_COUNT == BIN_COUNT, "every free bin needs a place in MemoryStats");
 
 //-----------------------------------------------------------------------------
 // Private Classes
 //-----------------------------------------------------------------------------
 
-//! The class to be used to keep track of allocations and deallocations
+//! The class to be used to keep track of allocations and deallocations, each
+//! arena is one of these with its own lock, pages and free bins
 class MemoryManager
 {
 public:
@@ -52,46 +88,236 @@ public:
   void Init(void);
   void Shutdown(void);
   void* Allocate(size_t memSize);
+  void AllocateRun(size_t memSize, size_t count, void** blocks);
+  void* AllocateAligned(size_t memSize, size_t alignment);
   void Destroy(void* ptr);
+  void DestroyRun(void** blocks, size_t count);
+  bool Resize(void* ptr, size_t memSize);
+  bool Owns(const void* ptr) const;
+  void RemoteDestroy(void* first, void* last);
+  size_t IdleBytes(void);
+  size_t Purge(uint64_t now, uint64_t minIdle, size_t limit);
+  size_t AddStats(MemoryStats& stats, size_t& largest);
+
+  bool TryLock(void);
+  void Lock(void);
+  void Unlock(void);
+  size_t Contention(void) const;
 
   MemoryManager& operator=(const MemoryManager& rhs);
 
-  bool isInitialized = false;
+  unsigned int index = 0; //!< the position of the arena in arenas, stamped on every block it hands out
 
 private:
 
+  std::mutex mLock;       //!< held while the pages, bins or heap are being changed
+
+  std::atomic<size_t> mContention; //!< the number of times a thread found the lock already held
+
+  std::atomic<void*> mRemoteFrees; //!< blocks freed without the lock, linked through their user memory
+
   MemoryBlock mHeap;      //!< the current heap of the manager
 
-  std::vector<MemoryPage, MemoryAllocator<MemoryPage>> mPageVec; //!< a vector of all allocated pages
+  std::vector<MemoryPage, MemoryPageAllocator<MemoryPage>> mPageVec; //!< a vector of all allocated pages
+
+  MemoryBins mFreeBins;   //!< free blocks sorted into size class bins
+
+  MemoryPageSource mSource; //!< the chunks of system memory the pages are carved from
+
+  std::vector<MemorySlab, MemoryPageAllocator<MemorySlab>> mSlabVec; //!< a vector of all slab pages
+
+  unsigned int mSlabLists[SLAB_CLASS_COUNT]; //!< one more than the index of the first slab of each class with free objects, 0 when every slab is full
+
+  unsigned int mFreeSlabs; //!< one more than the index of the first empty slab, any class or a page of blocks can take it, 0 when there is none
 
-  MANAGER_SIZE_TABLE mFreeSize; //!< hash table of all free blocks sorted by size, inserted by elementSize * numElements
-  MANAGER_LOC_TABLE mFreeLoc;   //!< hash table of all free blocks sorted by location, inserted by MemoryBlock void*
+  unsigned int mLentSlabs; //!< one more than the index of the first slab whose memory is a page of blocks, 0 when there is none
 
+  size_t mPurgedCount;    //!< the number of pages purged and waiting in mPageVec to be used again
 
-  void* AllocatePage(size_t pageSize = PAGE_SIZE);
+  uint64_t mLastPurge;    //!< the time in milliseconds of the last decay pass
+
+  bool mPurgeDue;         //!< set while a page or slab is idle but not purged, so a decay pass has work to do
+
+  size_t mBinHits;        //!< the blocks found in a free bin, only changed under the lock
+
+  size_t mHeapHits;       //!< the blocks split from the heap, only changed under the lock
+
+  size_t mNewPages;       //!< the times the heap was replaced with a new page, only changed under the lock
+
+  void DrainRemoteFrees(void);
+  void* AllocateBlock(size_t memSize);
+  void* AllocateSlab(size_t classIndex);
+  void AllocateSlabRun(size_t classIndex, size_t count, void** objects);
+  void DestroySlab(void* ptr, const PageMapEntry& entry);
+  void DestroySlabList(void* first, void* last, size_t count, const PageMapEntry& entry);
+  void RelistSlab(const PageMapEntry& entry, bool wasFull);
+  MemorySlab& AllocateSlabPage(size_t classIndex);
+  unsigned int ReclaimSlab(void);
+  void PushSlab(unsigned int& list, unsigned int slabIndex);
+  void UnlinkSlab(unsigned int& list, unsigned int slabIndex);
+  MemoryBlock AllocatePage(size_t minSize);
+  MemoryBlock GrowHeap(size_t memSize);
   void* AllocateMemoryFromHeap(size_t size);
   void AddPageToFree(void* page);
   void AddBlockToFree(MemoryBlock& block);
+  void FreeBlock(MemoryAllocated* memoryAlloced);
+  void MarkIdlePage(MemoryAllocated* memoryAlloced);
+  uint64_t MarkIdle(void);
+  void* UseBlock(void* block);
+  void SplitBlock(void* block, size_t size);
   void MoveBlock(MemoryBlock& block, size_t amount, bool right);
-  bool GetHeapFromFreeMap(void);
-  bool IsInPage(void* ptr, unsigned int pageIndex) const;
-  unsigned int PageIndex(void* ptr) const;
+  bool GetHeapFromFreeMap(size_t minSize);
+  bool IsInPage(const void* ptr, unsigned int pageIndex) const;
+  unsigned int PageIndex(const void* ptr) const;
+};
+
+//! Counters a thread keeps about its own calls. Only the owning thread writes
+//! them, with a plain load and store instead of a locked add, so counting
+//! never writes a cache line another thread writes. GetStats reads them
+struct ThreadStats
+{
+  std::atomic<size_t> allocations;  //!< blocks handed out
+  std::atomic<size_t> frees;        //!< blocks given back
+  std::atomic<size_t> uncached;     //!< allocations that went past the cache to an arena or a mapping
+  std::atomic<size_t> refills;      //!< batches taken from an arena for an empty cache list
+  std::atomic<size_t> flushes;      //!< batches given back to an arena from a full cache list
+  std::atomic<size_t> largeMaps;    //!< blocks given a mapping of their own
+  std::atomic<size_t> largeUnmaps;  //!< mappings of blocks given back
+  std::atomic<size_t> largeMapped;  //!< bytes mapped for blocks, growth in place included
+  std::atomic<size_t> largeUnmapped;//!< bytes unmapped for blocks, shrinking in place included
+};
+
+//! The cache of the calling thread, its blocks go back to the manager when the
+//! thread exits. Every cache is linked into a list so GetStats can find the
+//! counters of every thread
+class ThreadCache : public MemoryCache
+{
+public:
+
+  ThreadCache(void);
+  ~ThreadCache(void);
+
+  void Flush(size_t index, size_t count);
+
+  unsigned int arena; //!< the arena the thread allocates from, changed when the thread sees contention
+
+  unsigned int generation; //!< the value of cacheGeneration when the cache was last known to be valid
+
+  ThreadStats stats;  //!< the counters of the thread
+
+  ThreadCache* prev;  //!< the cache of the thread before this one in threadCaches
+  ThreadCache* next;  //!< the cache of the thread after this one in threadCaches
+};
+
+//! A thread that wakes a few times per decay time and purges the pages of
+//! every arena that have been idle for longer than it, so memory goes back to
+//! the system even when the program stops freeing anything
+class PurgeThread
+{
+public:
+
+  PurgeThread(void);
+  ~PurgeThread(void);
+
+  void Start(void);
+  void Stop(void);
+
+private:
+
+  std::thread mThread;                //!< the thread doing the passes, not joinable while stopped
+  std::mutex mLock;                   //!< guards mRunning
+  std::condition_variable mWake;      //!< signalled to stop the thread early
+  bool mRunning;                      //!< false once the thread should exit
+
+  void Run(void);
 };
 
-MemoryManager manager;
+//! Marks the manager as shut down when static destruction reaches it, before
+//! the arenas are destroyed, so blocks freed by destructors that run after it
+//! are left where they are instead of going back to arenas that are gone
+class ExitGuard
+{
+public:
+
+  ~ExitGuard(void);
+};
 
 //-----------------------------------------------------------------------------
 // Private Function Declerations
 //-----------------------------------------------------------------------------
 
-MANAGER_SIZE_TABLE::iterator SearchSizeTable(void* ptr, size_t size, MANAGER_SIZE_TABLE& table);
-MANAGER_LOC_TABLE::iterator SearchLocTable(void* ptr, MANAGER_LOC_TABLE& table);
+bool InitArenas(void);
+MemoryManager& LockThreadArena(void);
+MemoryManager& LockArena(unsigned int index);
+void AllocateBatch(size_t memSize, size_t count, void** blocks);
+void DestroyBatch(void** blocks, size_t count);
+void CheckCache(void);
+void* CacheAllocate(size_t size);
+void CacheDestroy(void* ptr, const PageMapEntry& entry);
+void CacheDestroySized(void* ptr, size_t size);
+void* SystemAllocate(size_t size);
+void* LargeAllocate(size_t size, size_t alignment);
+void LargeDestroy(void* ptr);
+void* LargeRealloc(void* ptr, size_t size);
+uint64_t CurrentTime(void);
+size_t PurgeArenas(uint64_t minIdle, size_t limit);
+void SetConfig(const MemoryConfig& config);
+void ReadEnvironment(void);
+bool ReadSize(const char* name, size_t& value);
+void Count(std::atomic<size_t>& counter, size_t amount = 1);
+void AddThreadStats(MemoryStats& stats, const ThreadStats& threadStats);
+void Trace(MemoryTraceOp op, size_t size, const void* ptr);
+void Profile(size_t size, const void* ptr);
+void ProfileDestroy(const void* ptr);
+void RecordResize(const void* ptr, const void* memory, size_t size);
+void RecordBatch(size_t size, void* const* blocks, size_t count);
+void DetachTrace(void);
 
 //-----------------------------------------------------------------------------
-// Public Functions
+// Private Variables
 //-----------------------------------------------------------------------------
 
+MemoryPageMap pageMap;            //!< maps every address in a page to the arena and page that hold it
+
+MemoryTrace memoryTrace;          //!< records every allocation and free while a trace is running, stopped when the program exits
+
+MemoryProfile memoryProfile;      //!< samples allocations with their call stacks while a profile is running
+
+MemoryManager arenas[ARENA_MAX];  //!< every arena, only the first arenaCount are handed to threads
+
+unsigned int arenaCount = 1;      //!< the number of arenas in use, one per core
+
+std::atomic<unsigned int> nextArena(0); //!< the arena the next new thread starts on
+
+std::atomic<size_t> pageSize(PAGE_SIZE - 2 * sizeof(MemoryAllocated)); //!< the usable bytes in a new page, without its header and fence
+
+std::atomic<size_t> initialPages(INITIAL_PAGES);  //!< the pages MemoryManagerInit gives the first arena
+
+std::atomic<size_t> pageGrowth(PAGE_GROWTH);  //!< the percent of the pages an arena holds that it adds at once when it runs out
+
+std::atomic<size_t> largeThreshold(LARGE_THRESHOLD); //!< the smallest block that gets a system mapping of its own
+
+std::atomic<size_t> decayTime(DECAY_TIME); //!< the milliseconds a whole free page stays resident before a decay pass purges it
+
+bool isInitialized = InitArenas();  //!< false until the arenas are constructed and after shutdown
+
+ExitGuard exitGuard;      //!< clears isInitialized when the program exits, defined after the arenas so it goes first
+
+PurgeThread purgeThread;  //!< purges idle pages in the background once it is started
+
+std::mutex statsLock;     //!< guards threadCaches and retiredStats
+
+ThreadCache* threadCaches = NULL; //!< the caches of every running thread, linked through their prev and next
 
+ThreadStats retiredStats; //!< the counters of every thread that has exited
+
+std::atomic<unsigned int> cacheGeneration(0); //!< changed by every shutdown, a cache filled before it holds blocks of released pages
+
+thread_local ThreadCache threadCache;
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
 
 /*!****************************************************************************
 \brief
@@ -108,13 +334,13 @@ void* operator new(size_t size)
   if (size)
   {   
       // if manager is not initialized
-    if (!manager.isInitialized)
+    if (!isInitialized)
     {
-      return MemoryAllocator<char>().allocate(size);  // allocate from the memory allocator
+      return SystemAllocate(size);
     }
     else
     {
-      return manager.Allocate(size);
+      return CacheAllocate(size);
     }
   }
 
@@ -126,13 +352,13 @@ void* operator new[](size_t size)
   if (size)
   {
     // if manager is not initialized
-    if (!manager.isInitialized)
+    if (!isInitialized)
     {
-      return MemoryAllocator<char>().allocate(size);  // allocate from the memory allocator
+      return SystemAllocate(size);
     }
     else
     {
-      return manager.Allocate(size);
+      return CacheAllocate(size);
     }
   }
 
@@ -141,324 +367,3578 @@ void* operator new[](size_t size)
 
 /*!****************************************************************************
 \brief
-  Deletes a given pointer from the memory manager
+  Deletes a given pointer from the memory manager, pointers that are not in
+  any page were allocated before the manager was ready and go to free
 
 \param ptr
   the pointer to delete
 ******************************************************************************/
-void operator delete(void* ptr)
+void operator delete(void* ptr) noexcept
 {
   if (ptr)
   {
-    if (!manager.isInitialized)
+    PageMapEntry entry = pageMap.Find(ptr);
+
+    // if the pointer is in one of the manager's pages
+    if (entry.page)
     {
-      MemoryAllocator<char>().deallocate(static_cast<char*>(ptr));
+      CacheDestroy(ptr, entry);
     }
     else
     {
-      manager.Destroy(ptr);
+      free(ptr); // allocated before the manager was ready
     }
   }
 }
 
-void operator delete[](void* ptr)
+void operator delete[](void* ptr) noexcept
 {
   if (ptr)
   {
-    if (!manager.isInitialized)
+    PageMapEntry entry = pageMap.Find(ptr);
+
+    // if the pointer is in one of the manager's pages
+    if (entry.page)
     {
-      MemoryAllocator<char>().deallocate(static_cast<char*>(ptr));
+      CacheDestroy(ptr, entry);
     }
     else
     {
-      manager.Destroy(ptr);
+      free(ptr); // allocated before the manager was ready
     }
   }
 }
 
-void MemoryManagerInit(void)
+/*!****************************************************************************
+\brief
+  Deletes a pointer whose size the compiler knows, the block goes back to the
+  cache without its header being read
+
+\param ptr
+  the pointer to delete
+
+\param size
+  the size that was passed to operator new
+******************************************************************************/
+void operator delete(void* ptr, size_t size) noexcept
 {
-  manager.Init();
+  if (ptr)
+  {
+    // if the pointer is in one of the manager's pages
+    if (pageMap.Find(ptr).page)
+    {
+      CacheDestroySized(ptr, size);
+    }
+    else
+    {
+      free(ptr); // allocated before the manager was ready
+    }
+  }
 }
 
-void* Alloc(size_t size)
+void operator delete[](void* ptr, size_t size) noexcept
 {
-  return manager.Allocate(size);
+  operator delete(ptr, size);
 }
 
-void Delete(void* ptr)
+/*!****************************************************************************
+\brief
+  Allocates a given size in bytes from the memoryManager at an address that
+  is a multiple of a given alignment, used for over aligned types
+
+\param size
+  the number of bytes to allocate
+
+\param alignment
+  the alignment of the type
+
+\return
+  a pointer to the allocated memory
+******************************************************************************/
+void* operator new(size_t size, std::align_val_t alignment)
 {
-  manager.Destroy(ptr);
+  // if manager is not initialized
+  if (!isInitialized)
+  {
+#if defined(_WIN32)
+    void* memory = _aligned_malloc(size ? size : 1, (size_t)(alignment));
+#else
+    void* memory = NULL;
+    posix_memalign(&memory, (size_t)(alignment), size ? size : 1);
+#endif
+
+    // if the system could not allocate the memory
+    if (memory == NULL)
+    {
+      throw std::bad_alloc();
+    }
+
+    return memory;
+  }
+
+  return AllocAligned(size, (size_t)(alignment));
 }
 
-void MemoryManagerShutdown(void)
+void* operator new[](size_t size, std::align_val_t alignment)
 {
-  manager.Shutdown();
+  return operator new(size, alignment);
 }
 
-//-----------------------------------------------------------------------------
-// Private Functions
-//-----------------------------------------------------------------------------
-
 /*!****************************************************************************
 \brief
-  Searches the size table for a block that matches the given parameters
+  Deletes a pointer from the aligned operator new, pointers that are not in
+  any page were allocated by the system before the manager was ready
 
 \param ptr
-  the pointer of the block to look for
-
-\param size
-  the size of the block to look for
-
-\param table
-  the table to search for the given information in
+  the pointer to delete
 
-\return
-  an iterator to the matching block, else returns the end of the size table
+\param alignment
+  the alignment of the type
 ******************************************************************************/
-MANAGER_SIZE_TABLE::iterator SearchSizeTable(void* ptr, size_t size, MANAGER_SIZE_TABLE& table)
+void operator delete(void* ptr, std::align_val_t /* alignment */) noexcept
 {
-  std::pair<MANAGER_SIZE_TABLE::iterator, MANAGER_SIZE_TABLE::iterator> temp = table.equal_range(size);
-
-  // while we are still looking through the iterator
-  while (temp.first != temp.second)
+  if (ptr)
   {
-    // if the curreny block has the same mem location
-    if (temp.first->second.MemoryLocation() == ptr)
+    PageMapEntry entry = pageMap.Find(ptr);
+
+    // if the pointer is in one of the manager's pages
+    if (entry.page)
     {
-      return temp.first;
+      CacheDestroy(ptr, entry);
     }
     else
     {
-      ++temp.first; // move to next block in iterator
+#if defined(_WIN32)
+      _aligned_free(ptr);
+#else
+      free(ptr);
+#endif
     }
   }
+}
 
-  return table.end();
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+  operator delete(ptr, alignment);
 }
 
 /*!****************************************************************************
 \brief
-  Searches the location table for a block that matches the given parameters
+  Deletes a pointer from the aligned operator new whose size the compiler
+  knows, the block goes back to the cache without its header being read
 
 \param ptr
-  the pointer of the block to look for
+  the pointer to delete
 
-\param table
-  the table to search for the given pointer in
+\param size
+  the size that was passed to operator new
 
-\return
-  an iterator to the matching block, else returns the end of the table
+\param alignment
+  the alignment of the type
 ******************************************************************************/
-MANAGER_LOC_TABLE::iterator SearchLocTable(void* ptr, MANAGER_LOC_TABLE& table)
+void operator delete(void* ptr, size_t size, std::align_val_t /* alignment */) noexcept
 {
-  return table.find(ptr);
+  if (ptr)
+  {
+    // if the pointer is in one of the manager's pages
+    if (pageMap.Find(ptr).page)
+    {
+      CacheDestroySized(ptr, size);
+    }
+    else
+    {
+#if defined(_WIN32)
+      _aligned_free(ptr);
+#else
+      free(ptr);
+#endif
+    }
+  }
 }
 
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-
-//-----------------------------------------------------------------------------
-// Class: MemoryManager
-//-----------------------------------------------------------------------------
-
-//-----------------------------------------------------------------------------
-// Public Class Functions
-//-----------------------------------------------------------------------------
+void operator delete[](void* ptr, size_t size, std::align_val_t alignment) noexcept
+{
+  operator delete(ptr, size, alignment);
+}
 
 /*!****************************************************************************
 \brief
-  A default constructor for a memoryManager, starts with 10 pages
+  Gives the first arena its initial pages with the settings already in use,
+  the defaults or what the environment changed them to
 ******************************************************************************/
-MemoryManager::MemoryManager(void) :
-  mHeap(),
-  mPageVec(0),
-  mFreeSize(),
-  mFreeLoc()
+void MemoryManagerInit(void)
 {
+  MemoryManager& arena = LockArena(0);
+
+  arena.Init();
+  arena.Unlock();
+
   isInitialized = true;
 }
 
 /*!****************************************************************************
 \brief
-  Allocates all pages and initializes the heap of the memory manager
+  Changes every setting the manager grows its arenas with, then gives the
+  first arena its initial pages. Pages mapped earlier keep their size
+
+\param config
+  the settings to use, MemoryManagerGetConfig fills in the current ones
 ******************************************************************************/
-void MemoryManager::Init(void)
+void MemoryManagerInit(const MemoryConfig& config)
 {
-  // for all pages in the manager
-  for (unsigned int i = 0; i < 20; ++i)
-  {
-    void* page = manager.AllocatePage();  // allocate a new page
+  SetConfig(config);
+  MemoryManagerInit();
+}
 
-    MemoryBlock temp(page, PAGE_SIZE);
+/*!****************************************************************************
+\brief
+  Gets the settings the manager is using, so a few of them can be changed
+  before they are passed to MemoryManagerInit
 
-    manager.mFreeLoc.insert(std::pair<void*, MemoryBlock>(temp.MemoryLocation(), temp));  // insert new block into free loc table
-    manager.mFreeSize.insert(std::pair<size_t, MemoryBlock>(temp.Size(), temp));
-  }
+\param config
+  filled with the current settings
+******************************************************************************/
+void MemoryManagerGetConfig(MemoryConfig& config)
+{
+  config.pageSize = pageSize.load(std::memory_order_relaxed) + 2 * sizeof(MemoryAllocated);
+  config.initialPages = initialPages.load(std::memory_order_relaxed);
+  config.pageGrowth = pageGrowth.load(std::memory_order_relaxed);
+  config.largeThreshold = largeThreshold.load(std::memory_order_relaxed);
+  config.decayTime = decayTime.load(std::memory_order_relaxed);
+}
 
-  manager.GetHeapFromFreeMap(); // get the heap
+void* Alloc(size_t size)
+{
+  return CacheAllocate(size);
+}
 
-  isInitialized = true;
+void Delete(void* ptr)
+{
+  CacheDestroy(ptr, pageMap.Find(ptr));
 }
 
 /*!****************************************************************************
 \brief
-  frees all dynamic MemoryManager memory
-******************************************************************************/
-void MemoryManager::Shutdown(void)
-{
-  size_t size = manager.mPageVec.size();
+  Destroys a block whose size the caller knows. Neither the block's header
+  nor the page map is read, blocks the cache holds go straight to the list of
+  their size class
 
-  // for all allocated pages in manager
-  for (size_t i = 0; i < size; ++i)
-  {
-    manager.mPageVec[i].Destroy();  // free current page
-  }
+\param ptr
+  the block to destroy, from Alloc, Realloc or AllocAligned
 
-  isInitialized = false;
+\param size
+  the size passed to the call that returned the block
+******************************************************************************/
+void Delete(void* ptr, size_t size)
+{
+  CacheDestroySized(ptr, size);
 }
 
 /*!****************************************************************************
 \brief
-  Allocates a given size in bytes
+  Changes the size of a block with the semantics of C realloc, keeping its
+  contents up to the smaller of the two sizes. A block in an arena is shrunk
+  in place or grown into the free block or heap right after it, a block with
+  a mapping of its own is resized by the system. Only when that fails is the
+  block moved to a new one
 
-\param memSize
-  the number of bytes to be allocated
+\param ptr
+  the block to resize, NULL allocates a new block
+
+\param size
+  the new size in bytes, 0 destroys the block
 
 \return
-  a pointer to the memory allocated
+  the resized block, it may have moved. NULL if size was 0 or there was not
+  enough memory, the old block is then left untouched
 ******************************************************************************/
-void* MemoryManager::Allocate(size_t memSize)
+void* Realloc(void* ptr, size_t size)
 {
-  void* mem = NULL;
-  MANAGER_SIZE_TABLE::iterator it = mFreeSize.find(memSize);
+  // if there is no block yet
+  if (ptr == NULL)
+  {
+    try
+    {
+      return Alloc(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+      return NULL;
+    }
+  }
+
+  // if the block is no longer needed
+  if (size == 0)
+  {
+    Delete(ptr);
+    return NULL;
+  }
+
+  PageMapEntry entry = pageMap.Find(ptr);
 
-  // if a matching block was found
-  if (it != mFreeSize.end())
+  // if the block was allocated before the manager was ready
+  if (entry.page == 0)
   {
-    mem = it->second.MemoryLocation(); // hold memory location
+    return realloc(ptr, size);
+  }
+
+  size_t oldSize;
+
+  // if the block is an object in a slab
+  if (entry.slab)
+  {
+    oldSize = MemoryBins::ClassSize(entry.slab - 1);
 
-    mFreeLoc.erase(it->second.MemoryLocation());  // remove block from loc table
-    mFreeSize.erase(it);                          // remove block from size table
+    // if the object's size class still holds the new size
+    if (size <= oldSize)
+    {
+      RecordResize(ptr, ptr, size);
+      return ptr;
+    }
   }
   else
   {
-    mem = AllocateMemoryFromHeap(memSize);
+    MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(ptr);
+    bool large = size > CACHE_MAX_SIZE && size >= largeThreshold.load(std::memory_order_relaxed); // blocks the cache can hold never get a mapping of their own
+    size_t memSize = (size <= CACHE_MAX_SIZE) ? MemoryBins::ClassSize(MemoryBins::ClassIndex(size)) : size;  // a block the cache can hold keeps a whole size class, so a sized Delete can find its class
 
-    // if we could not allocate from the heap
-    if (mem == NULL)
+    oldSize = memoryAlloced->Size();
+
+    // if the block has a mapping of its own
+    if (memoryAlloced->IsLarge())
     {
-      AddBlockToFree(mHeap);
+      void* memory = large ? LargeRealloc(ptr, size) : NULL;
 
-      // if the mem size is smaller than a page
-      if (memSize + sizeof(MemoryAllocated) < PAGE_SIZE)
+      // if the system resized the mapping
+      if (memory)
       {
-        it = mFreeSize.find(PAGE_SIZE); // search for a free page
+        RecordResize(ptr, memory, size);
+        return memory;
+      }
+    }
+    // if the block shrinks by too little to split off the rest
+    else if (oldSize >= memSize && oldSize - memSize < sizeof(MemoryAllocated) + MIN_BLOCK_SIZE)
+    {
+      RecordResize(ptr, ptr, size);
+      return ptr;
+    }
+    // if the block is staying in its arena
+    else if (!large)
+    {
+      MemoryManager& arena = LockArena(memoryAlloced->Owner());
+      bool resized = arena.Resize(ptr, memSize);
 
-          // if a page was found
-        if (it != mFreeSize.end())
-        {
-          mHeap = it->second; // hold page as new heap
+      arena.Unlock();
 
-          mFreeLoc.erase(mHeap.MemoryLocation()); // erase found heap from free and loc tables
-          mFreeSize.erase(it);
-        }
-        // no new page was found
-        else
-        {
-          mHeap = MemoryBlock(AllocatePage(), PAGE_SIZE); // allocate a new page
-        }
-      }
-      // memSize is larger than a page
-      else
+      // if the block changed size where it is
+      if (resized)
       {
-        mHeap = MemoryBlock(AllocatePage(memSize), memSize); // allocate a memSize sized page
+        RecordResize(ptr, ptr, size);
+        return ptr;
       }
-
-      mem = AllocateMemoryFromHeap(memSize);  // allocate memory
     }
   }
 
-  return mem;
-}
+  void* memory;
 
-/*!****************************************************************************
-\brief
-  Destroys a given pointer in the manager
+  try
+  {
+    memory = Alloc(size);
+  }
+  catch (const std::bad_alloc&)
+  {
+    return NULL;
+  }
 
-\param ptr
-  the address of the MemoryBlock to destroy
-******************************************************************************/
-void MemoryManager::Destroy(void* ptr)
-{
-  unsigned int memSize = *(unsigned int*)((uintptr_t)(ptr)-sizeof(MemoryAllocated));
-  MemoryBlock temp(ptr, memSize);
+  memcpy(memory, ptr, oldSize < size ? oldSize : size);
+  Delete(ptr);
 
-  mFreeLoc.insert(std::pair<void*, MemoryBlock>(ptr, temp));
-  mFreeSize.insert(std::pair<size_t, MemoryBlock>(memSize, temp));
+  return memory;
 }
 
-MemoryManager& MemoryManager::operator=(const MemoryManager& rhs)
-{
-  mHeap = rhs.mHeap;
-  mFreeSize = rhs.mFreeSize;
-  mFreeLoc = rhs.mFreeLoc;
-  mPageVec = rhs.mPageVec;
+/*!****************************************************************************
+\brief
+  Allocates a block whose address is a multiple of a given alignment, the
+  block is destroyed with Delete like any other
 
-  return *this;
-}
+\param size
+  the number of bytes to allocate
 
-//-----------------------------------------------------------------------------
-// Private Class Functions
-//-----------------------------------------------------------------------------
+\param alignment
+  a power of two the address must be a multiple of
 
-bool MemoryManager::IsInPage(void* ptr, unsigned int pageIndex) const
+\return
+  a pointer to the allocated memory, NULL if alignment is not a power of two
+******************************************************************************/
+void* AllocAligned(size_t size, size_t alignment)
 {
-  if (pageIndex < mPageVec.size())
+  // if the alignment is not a power of two
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0)
   {
-    const void* pagePtr = mPageVec[pageIndex].Ptr();
-
-    return ((ptr >= pagePtr) && ((uintptr_t)(ptr) < ((uintptr_t)(pagePtr)+mPageVec[pageIndex].Size())));
+    return NULL;
+  }
+
+  // if every block is already aligned enough
+  if (alignment <= BIN_ALIGNMENT)
+  {
+    return Alloc(size);
+  }
+
+  Count(threadCache.stats.allocations);
+  Count(threadCache.stats.uncached);
+
+  void* block;
+
+  // if the block is too big for the cache and big enough for a mapping of its own
+  if (size > CACHE_MAX_SIZE && size + alignment >= largeThreshold.load(std::memory_order_relaxed))
+  {
+    block = LargeAllocate(size, alignment);
+  }
+  else
+  {
+    size_t memSize = (size <= CACHE_MAX_SIZE) ? MemoryBins::ClassSize(MemoryBins::ClassIndex(size)) : size;  // a whole size class, so a sized Delete can find its class
+    MemoryManager& arena = LockThreadArena();
+
+    block = arena.AllocateAligned(memSize, alignment);
+    arena.Unlock();
+  }
+
+  Trace(MEMORY_TRACE_ALLOC, size, block);
+  Profile(size, block);
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Allocates an aligned block with the semantics of POSIX posix_memalign
+
+\param memptr
+  set to the allocated block
+
+\param alignment
+  a power of two that is a multiple of sizeof(void*)
+
+\param size
+  the number of bytes to allocate
+
+\return
+  0 on success, EINVAL for a bad alignment, ENOMEM if there was not enough
+  memory
+******************************************************************************/
+int PosixMemalign(void** memptr, size_t alignment, size_t size)
+{
+  // if the alignment is not a power of two multiple of a pointer
+  if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0)
+  {
+    return EINVAL;
+  }
+
+  try
+  {
+    *memptr = AllocAligned(size, alignment);
+  }
+  catch (const std::bad_alloc&)
+  {
+    return ENOMEM;
+  }
+
+  return 0;
+}
+
+/*!****************************************************************************
+\brief
+  Allocates an aligned block with the semantics of C11 aligned_alloc
+
+\param alignment
+  a power of two
+
+\param size
+  the number of bytes to allocate
+
+\return
+  the allocated block, NULL for a bad alignment or if there was not enough
+  memory
+******************************************************************************/
+void* AlignedAlloc(size_t alignment, size_t size)
+{
+  try
+  {
+    return AllocAligned(size, alignment);
+  }
+  catch (const std::bad_alloc&)
+  {
+    return NULL;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Maps pages straight from the page source for a pool that manages the memory
+  itself, the pages are not in any arena and can not be passed to Delete
+
+\param size
+  the number of bytes to map, rounded up to whole system pages
+
+\return
+  the mapped pages, NULL if the system is out of memory
+******************************************************************************/
+void* MemoryManagerMapPages(size_t size)
+{
+  return MemoryPageSource::MapDirect(size);
+}
+
+/*!****************************************************************************
+\brief
+  Gives pages from MemoryManagerMapPages back to the system
+
+\param ptr
+  the mapped pages
+
+\param size
+  the size they were mapped with
+******************************************************************************/
+void MemoryManagerUnmapPages(void* ptr, size_t size)
+{
+  MemoryPageSource::UnmapDirect(ptr, size);
+}
+
+/*!****************************************************************************
+\brief
+  Chooses how chunks mapped from now on are backed by the system
+
+\param mode
+  the kind of huge pages to ask for
+******************************************************************************/
+void MemoryManagerHugePages(MemoryHugePages mode)
+{
+  MemoryPageSource::SetHugePages(mode);
+}
+
+void MemoryManagerShutdown(void)
+{
+  purgeThread.Stop();
+
+  // every cache filled before now holds blocks of pages about to be released,
+  // the calling thread's is emptied here and the others when they next use it
+  cacheGeneration.fetch_add(1, std::memory_order_acq_rel);
+  CheckCache();
+
+  // for all arenas in use
+  for (unsigned int i = 0; i < arenaCount; ++i)
+  {
+    MemoryManager& arena = LockArena(i);
+
+    arena.Shutdown();
+    arena.Unlock();
+  }
+
+  isInitialized = false;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether a pointer is inside memory handed out by the manager
+
+\param ptr
+  the pointer to check
+
+\return
+  true if the pointer is in one of the manager's pages, else false
+******************************************************************************/
+bool MemoryManagerOwns(const void* ptr)
+{
+  return pageMap.Find(ptr).page != 0;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether the arenas can be used. Allocations made before the manager
+  is ready, or after the program has started to exit, have to come from
+  somewhere else
+
+\return
+  true while the arenas can be used, else false
+******************************************************************************/
+bool MemoryManagerReady(void)
+{
+  return isInitialized;
+}
+
+/*!****************************************************************************
+\brief
+  Destroys a block if it is in one of the manager's pages, with a single
+  page map lookup for both the check and the free
+
+\param ptr
+  the block to destroy
+
+\return
+  true if the manager owned the block, false if it was left alone
+******************************************************************************/
+bool TryDelete(void* ptr)
+{
+  PageMapEntry entry = pageMap.Find(ptr);
+
+  // if the block is not in one of the manager's pages
+  if (entry.page == 0)
+  {
+    return false;
+  }
+
+  CacheDestroy(ptr, entry);
+
+  return true;
+}
+
+/*!****************************************************************************
+\brief
+  Finds the number of bytes of a block the caller can use, at least the size
+  it was allocated with
+
+\param ptr
+  the block to measure
+
+\return
+  the usable bytes of the block, 0 if the manager does not own it
+******************************************************************************/
+size_t UsableSize(const void* ptr)
+{
+  PageMapEntry entry = pageMap.Find(ptr);
+
+  // if the block is not in one of the manager's pages
+  if (entry.page == 0)
+  {
+    return 0;
+  }
+
+  // if the block is an object in a slab
+  if (entry.slab)
+  {
+    return MemoryBins::ClassSize(entry.slab - 1);
+  }
+
+  return MemoryAllocated::FromMemory(const_cast<void*>(ptr))->Size();
+}
+
+/*!****************************************************************************
+\brief
+  Locks every arena and the list of thread caches, so a fork cannot copy one
+  of them into the child while another thread is changing it
+******************************************************************************/
+void MemoryManagerLock(void)
+{
+  // for all arenas
+  for (unsigned int i = 0; i < ARENA_MAX; ++i)
+  {
+    arenas[i].Lock();
+  }
+
+  statsLock.lock();
+}
+
+/*!****************************************************************************
+\brief
+  Unlocks everything MemoryManagerLock locked, in the parent and in the child
+  after a fork
+******************************************************************************/
+void MemoryManagerUnlock(void)
+{
+  statsLock.unlock();
+
+  // for all arenas
+  for (unsigned int i = ARENA_MAX; i > 0; --i)
+  {
+    arenas[i - 1].Unlock();
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Changes the size at which blocks stop coming from the arenas and get a
+  system mapping of their own, blocks that fit in the thread cache never do
+
+\param size
+  the smallest block in bytes that gets its own mapping
+******************************************************************************/
+void MemoryManagerLargeThreshold(size_t size)
+{
+  largeThreshold.store(size, std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Changes how long a page or slab has to stay wholly free before a decay
+  pass purges it. Passes run while blocks are freed, at most four times per
+  decay time, and in the background once MemoryManagerBackgroundPurge is on
+
+\param milliseconds
+  the time a free page stays resident, 0 purges pages as soon as a pass sees
+  them and MEMORY_DECAY_NEVER leaves them until Trim is called
+******************************************************************************/
+void MemoryManagerDecay(size_t milliseconds)
+{
+  decayTime.store(milliseconds, std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Starts or stops the thread that runs decay passes without waiting for the
+  program to free something
+
+\param enable
+  true to start the thread, false to stop it
+******************************************************************************/
+void MemoryManagerBackgroundPurge(bool enable)
+{
+  // if the thread is being started
+  if (enable)
+  {
+    purgeThread.Start();
+  }
+  else
+  {
+    purgeThread.Stop();
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Gives free memory back to the system now instead of waiting for it to
+  decay. The calling thread's cache is flushed first, then whole free pages
+  and empty slabs are purged, no matter how long they have been idle, until
+  at most targetBytes of them are left resident
+
+\param targetBytes
+  the number of idle bytes the arenas may keep, 0 purges all of them
+
+\return
+  the number of bytes given back to the system
+******************************************************************************/
+size_t Trim(size_t targetBytes)
+{
+  CheckCache();
+
+  // for all size classes
+  for (size_t i = 0; i < CACHE_CLASS_COUNT; ++i)
+  {
+    // while the list has blocks
+    while (!threadCache.Empty(i))
+    {
+      threadCache.Flush(i, CACHE_BATCH_SIZE);
+    }
+  }
+
+  size_t idle = 0;
+
+  // for all arenas in use
+  for (unsigned int i = 0; i < arenaCount; ++i)
+  {
+    MemoryManager& arena = LockArena(i);
+
+    idle += arena.IdleBytes();
+    arena.Unlock();
+  }
+
+  // if the arenas already keep little enough
+  if (idle <= targetBytes)
+  {
+    return 0;
+  }
+
+  return PurgeArenas(0, idle - targetBytes);
+}
+
+/*!****************************************************************************
+\brief
+  Gathers what the manager is doing. The counters of every thread are added
+  up, then every arena is locked in turn and its pages and bins measured, so
+  the figures of different arenas can be a moment apart
+
+\param stats
+  filled with the statistics
+******************************************************************************/
+void GetStats(MemoryStats& stats)
+{
+  memset(&stats, 0, sizeof(stats));
+
+  {
+    std::lock_guard<std::mutex> lock(statsLock);
+
+    AddThreadStats(stats, retiredStats);
+
+    // for all running threads
+    for (const ThreadCache* cache = threadCaches; cache; cache = cache->next)
+    {
+      AddThreadStats(stats, cache->stats);
+    }
+  }
+
+  size_t blockBytes = 0; // free in bins and heaps of pages partly in use, slab objects can never merge into a bigger block
+  size_t largest = 0;    // the biggest of those blocks
+
+  // for all arenas in use
+  for (unsigned int i = 0; i < arenaCount; ++i)
+  {
+    MemoryManager& arena = LockArena(i);
+
+    blockBytes += arena.AddStats(stats, largest);
+    arena.Unlock();
+  }
+
+  stats.bytesInUse = stats.pageBytes + stats.slabBytes + stats.largeBytes - stats.freeBytes;
+  stats.fragmentation = blockBytes ? 1.0 - (double)(largest) / (double)(blockBytes) : 0.0;
+}
+
+/*!****************************************************************************
+\brief
+  Writes the statistics for a person or a scraper to read, only bins that
+  hold blocks are listed. Nothing is allocated, so it can be called while
+  the program is short of memory
+
+\param file
+  the file to write to
+
+\param format
+  text with a name and value per line or a JSON object
+******************************************************************************/
+void DumpStats(FILE* file, MemoryStatsFormat format)
+{
+  MemoryStats stats;
+
+  GetStats(stats);
+
+  const char* names[] = { "allocations", "frees", "cache_hits", "cache_refills", "cache_flushes", "bin_hits", "heap_hits",
+                          "new_pages", "large_blocks", "large_bytes", "pages", "page_bytes", "slabs", "slab_bytes",
+                          "purged_bytes", "bytes_in_use", "free_bytes", "largest_free" };
+  size_t values[] = { stats.allocations, stats.frees, stats.cacheHits, stats.cacheRefills, stats.cacheFlushes, stats.binHits,
+                      stats.heapHits, stats.newPages, stats.largeBlocks, stats.largeBytes, stats.pages, stats.pageBytes,
+                      stats.slabs, stats.slabBytes, stats.purgedBytes, stats.bytesInUse, stats.freeBytes, stats.largestFree };
+  bool json = (format == MEMORY_STATS_JSON);
+  bool first = true;
+
+  fputs(json ? "{" : "", file);
+
+  // for all counters
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+  {
+    fprintf(file, json ? "\"%s\": %zu, " : "%s: %zu\n", names[i], values[i]);
+  }
+
+  fprintf(file, json ? "\"fragmentation\": %.4f, \"free_bins\": [" : "fragmentation: %.4f\n", stats.fragmentation);
+
+  // for all free bins
+  for (size_t i = 0; i < BIN_COUNT; ++i)
+  {
+    // if the bin holds no blocks
+    if (stats.binFreeBytes[i] == 0)
+    {
+      continue;
+    }
+
+    fprintf(file, json ? "%s{\"size\": %zu, \"bytes\": %zu}" : "%sfree_bin_%zu: %zu\n", (json && !first) ? ", " : "",
+            MemoryBins::ClassSize(i), stats.binFreeBytes[i]);
+    first = false;
+  }
+
+  fputs(json ? "]}\n" : "", file);
+}
+
+/*!****************************************************************************
+\brief
+  Starts recording every Alloc, Delete, Realloc, operator new and operator
+  delete to a file that can be replayed later. Each thread writes its own run
+  of the file without locking. Tracing can also be started for a whole run
+  of the program by setting MEMORY_TRACE to the path of the file
+
+\param path
+  the file to write, replaced if it exists
+
+\param size
+  the most bytes the file grows to, MEMORY_TRACE_SIZE is a good default.
+  Records past it are dropped and counted in the file's header
+
+\return
+  true if recording started, false if the file could not be created
+******************************************************************************/
+bool MemoryManagerTraceStart(const char* path, size_t size)
+{
+  return memoryTrace.Start(path, size);
+}
+
+/*!****************************************************************************
+\brief
+  Stops recording and finishes the trace file, a running trace is also
+  stopped when the program exits. No other thread may be allocating while
+  the trace stops
+******************************************************************************/
+void MemoryManagerTraceStop(void)
+{
+  memoryTrace.Stop();
+}
+
+/*!****************************************************************************
+\brief
+  Starts sampling allocations with their call stacks, throwing away an
+  earlier profile. About one allocation per rate bytes is sampled and kept
+  until it is freed, so the profile shows which code holds memory at a cost
+  far below a trace. Profiling can also be started for a whole run of the
+  program by setting MEMORY_PROFILE to the file the profile is written to
+  when it exits, and MEMORY_PROFILE_RATE to the rate
+
+\param rate
+  the average bytes allocated between samples, MEMORY_PROFILE_RATE is a good
+  default
+
+\return
+  true if sampling started, false if the rate was 0 or there was no memory
+  for the profile
+******************************************************************************/
+bool MemoryManagerProfileStart(size_t rate)
+{
+  return memoryProfile.Start(rate);
+}
+
+/*!****************************************************************************
+\brief
+  Stops sampling, the profile can still be written until the next start
+******************************************************************************/
+void MemoryManagerProfileStop(void)
+{
+  memoryProfile.Stop();
+}
+
+/*!****************************************************************************
+\brief
+  Writes the heap profile, the sampled blocks still live and every block
+  sampled since the profile started, by the call stack that allocated them
+
+\param file
+  the file to write to
+
+\param format
+  MEMORY_PROFILE_PPROF for pprof, or folded stacks for flame graphs
+
+\return
+  true if the profile was written, false if no profile was ever started
+******************************************************************************/
+bool MemoryManagerProfileDump(FILE* file, MemoryProfileFormat format)
+{
+  return memoryProfile.Dump(file, format);
+}
+
+/*!****************************************************************************
+\brief
+  Gets the number of arenas threads are spread over
+
+\return
+  the number of arenas in use
+******************************************************************************/
+unsigned int MemoryManagerArenaCount(void)
+{
+  return arenaCount;
+}
+
+/*!****************************************************************************
+\brief
+  Gets how many times a thread has found an arena's lock already held
+
+\param arena
+  the index of the arena, less than MemoryManagerArenaCount()
+
+\return
+  the number of contended lock attempts on the arena
+******************************************************************************/
+size_t MemoryManagerArenaContention(unsigned int arena)
+{
+  return arenas[arena].Contention();
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a number of blocks of the same size at once. Small blocks are
+  carved as a contiguous run from a slab and bigger ones as a run split out
+  of a single free block, all under one lock of the thread's arena
+
+\param size
+  the number of bytes in each block
+
+\param count
+  the number of blocks to allocate
+
+\param blocks
+  filled with the allocated blocks, must hold count pointers. Each block can
+  be freed on its own with Delete or together with DeleteBatch
+******************************************************************************/
+void AllocBatch(size_t size, size_t count, void** blocks)
+{
+  memset(blocks, 0, count * sizeof(void*)); // so a failed batch can be given back
+
+  Count(threadCache.stats.allocations, count);
+  Count(threadCache.stats.uncached, count);
+
+  try
+  {
+    // if the blocks are too big for the cache and big enough for mappings of their own
+    if (size > CACHE_MAX_SIZE && size >= largeThreshold.load(std::memory_order_relaxed))
+    {
+      // for all blocks being allocated
+      for (size_t i = 0; i < count; ++i)
+      {
+        blocks[i] = LargeAllocate(size, BIN_ALIGNMENT);
+      }
+    }
+    else
+    {
+      size_t memSize = (size <= CACHE_MAX_SIZE) ? MemoryBins::ClassSize(MemoryBins::ClassIndex(size)) : size;  // a whole size class, so a sized Delete can find its class
+
+      AllocateBatch(memSize, count, blocks);
+    }
+  }
+  catch (const std::bad_alloc&)
+  {
+    RecordBatch(size, blocks, count);  // DeleteBatch records the frees of the blocks that were allocated
+    DeleteBatch(blocks, count);
+    throw;
+  }
+
+  RecordBatch(size, blocks, count);
+}
+
+/*!****************************************************************************
+\brief
+  Destroys a number of blocks at once. The pointers are sorted by address so
+  the blocks of each arena and each slab sit together, every arena is then
+  locked once and every slab's free list updated once
+
+\param blocks
+  the blocks to destroy, NULL entries are skipped. The array is reordered
+
+\param count
+  the number of pointers in blocks
+******************************************************************************/
+void DeleteBatch(void** blocks, size_t count)
+{
+  size_t kept = 0;
+
+  // for all blocks
+  for (size_t i = 0; i < count; ++i)
+  {
+    void* ptr = blocks[i];
+
+    // if there is no block
+    if (ptr == NULL)
+    {
+      continue;
+    }
+
+    Count(threadCache.stats.frees);
+    Trace(MEMORY_TRACE_FREE, 0, ptr);
+    ProfileDestroy(ptr);
+
+    // if the block has a mapping of its own
+    if (pageMap.Find(ptr).slab == 0 && MemoryAllocated::FromMemory(ptr)->IsLarge())
+    {
+      LargeDestroy(ptr);
+    }
+    else
+    {
+      blocks[kept++] = ptr;
+    }
+  }
+
+  // if the blocks are not already in address order, as a batch from AllocBatch is
+  if (!std::is_sorted(blocks, blocks + kept))
+  {
+    std::sort(blocks, blocks + kept);
+  }
+
+  DestroyBatch(blocks, kept);
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a block from one given arena, skipping the thread cache. Blocks
+  kept in one arena this way stay together in memory and away from the
+  blocks of other threads, and only contend for that arena's lock
+
+\param heap
+  the index of the arena, less than MemoryManagerArenaCount()
+
+\param size
+  the number of bytes to allocate
+
+\param alignment
+  a power of two the address must be a multiple of
+
+\return
+  a pointer to the allocated memory, it must be freed with
+  MemoryManagerHeapDelete to stay in the arena
+******************************************************************************/
+void* MemoryManagerHeapAlloc(unsigned int heap, size_t size, size_t alignment)
+{
+  // if the alignment is smaller than every block already has
+  if (alignment < BIN_ALIGNMENT)
+  {
+    alignment = BIN_ALIGNMENT;
+  }
+
+  Count(threadCache.stats.allocations);
+  Count(threadCache.stats.uncached);
+
+  void* block;
+
+  // if the block is too big for the cache and big enough for a mapping of its own
+  if (size > CACHE_MAX_SIZE && size + alignment >= largeThreshold.load(std::memory_order_relaxed))
+  {
+    block = LargeAllocate(size, alignment);
+  }
+  else
+  {
+    MemoryManager& arena = LockArena(heap);
+
+    block = arena.AllocateAligned(size, alignment);
+    arena.Unlock();
+  }
+
+  Trace(MEMORY_TRACE_ALLOC, size, block);
+  Profile(size, block);
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Destroys a block straight into the arena that owns it, skipping the thread
+  cache so the memory is not handed to another arena's threads
+
+\param ptr
+  the block to destroy, NULL is ignored
+******************************************************************************/
+void MemoryManagerHeapDelete(void* ptr)
+{
+  // if there is no block
+  if (ptr == NULL)
+  {
+    return;
+  }
+
+  Count(threadCache.stats.frees);
+  Trace(MEMORY_TRACE_FREE, 0, ptr);
+  ProfileDestroy(ptr);
+
+  PageMapEntry entry = pageMap.Find(ptr);
+
+  // if the block has a mapping of its own
+  if (entry.slab == 0 && MemoryAllocated::FromMemory(ptr)->IsLarge())
+  {
+    LargeDestroy(ptr);
+    return;
+  }
+
+  MemoryManager& arena = LockArena(entry.arena);
+
+  arena.DestroyRun(&ptr, 1);  // the same as Destroy, but lets a decay pass run
+  arena.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Sets up the arenas before anything else in this file is used, one arena per
+  core up to ARENA_MAX, and reads the settings given in the environment
+
+\return
+  true once the arenas can be used
+******************************************************************************/
+bool InitArenas(void)
+{
+  unsigned int cores = std::thread::hardware_concurrency();
+
+  arenaCount = (cores == 0) ? 1 : ((cores < ARENA_MAX) ? cores : ARENA_MAX);
+
+#if !defined(_WIN32)
+  pthread_atfork(NULL, NULL, DetachTrace);  // a child must not write to the parent's trace
+#endif
+
+  ReadEnvironment();
+
+  // for all arenas
+  for (unsigned int i = 0; i < ARENA_MAX; ++i)
+  {
+    arenas[i].index = i;
+  }
+
+  return true;
+}
+
+/*!****************************************************************************
+\brief
+  Locks the arena of the calling thread. If its lock is held the thread moves
+  on to the next arena that is free, only waiting when every arena is busy
+
+\return
+  the locked arena, it must be unlocked by the caller
+******************************************************************************/
+MemoryManager& LockThreadArena(void)
+{
+  unsigned int start = threadCache.arena;
+
+  // for all arenas starting with the thread's own
+  for (unsigned int i = 0; i < arenaCount; ++i)
+  {
+    unsigned int index = (start + i) % arenaCount;
+
+    // if nobody else was using the arena
+    if (arenas[index].TryLock())
+    {
+      threadCache.arena = index;  // stay on the arena that was free
+      return arenas[index];
+    }
+  }
+
+  threadCache.arena = (start + 1) % arenaCount;  // every arena is busy, wait on the next one
+  arenas[threadCache.arena].Lock();
+
+  return arenas[threadCache.arena];
+}
+
+/*!****************************************************************************
+\brief
+  Locks a given arena, used when every arena has to be visited in turn
+
+\param index
+  the index of the arena
+
+\return
+  the locked arena, it must be unlocked by the caller
+******************************************************************************/
+MemoryManager& LockArena(unsigned int index)
+{
+  // if the lock is held by another thread
+  if (!arenas[index].TryLock())
+  {
+    arenas[index].Lock();
+  }
+
+  return arenas[index];
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a number of blocks of the same size from the thread's arena under
+  a single lock, slab objects and blocks are carved in contiguous runs
+
+\param memSize
+  the number of bytes in each block
+
+\param count
+  the number of blocks to allocate
+
+\param blocks
+  filled with the allocated blocks, must hold count pointers
+******************************************************************************/
+void AllocateBatch(size_t memSize, size_t count, void** blocks)
+{
+  MemoryManager& arena = LockThreadArena();
+
+  arena.AllocateRun(memSize, count, blocks);
+  arena.Unlock();
+}
+
+/*!****************************************************************************
+\brief
+  Destroys a number of blocks, each run of blocks owned by the same arena is
+  handled at once. A run owned by the thread's own arena is destroyed under a
+  single lock with each slab's free list updated once per run of its
+  objects, a run owned by another arena or whose lock is busy is pushed
+  onto that arena's remote free list without waiting
+
+\param blocks
+  the blocks to destroy
+
+\param count
+  the number of blocks
+******************************************************************************/
+void DestroyBatch(void** blocks, size_t count)
+{
+  size_t i = 0;
+
+  // while there are blocks left to destroy
+  while (i < count)
+  {
+    size_t start = i;
+    unsigned int owner = pageMap.Find(blocks[i]).arena; // slab objects have no header to hold the owner
+
+    // while the following blocks have the same owner
+    do
+    {
+      ++i;
+    } while (i < count && pageMap.Find(blocks[i]).arena == owner);
+
+    MemoryManager& arena = arenas[owner];
+
+    // if the run belongs to this thread's arena and nobody else is using it
+    if (owner == threadCache.arena && arena.TryLock())
+    {
+      arena.DestroyRun(blocks + start, i - start);
+      arena.Unlock();
+    }
+    else
+    {
+      // for all blocks in the run but the last
+      for (size_t j = start; j + 1 < i; ++j)
+      {
+        *(void**)(blocks[j]) = blocks[j + 1]; // chain the run together through the user memory
+      }
+
+      arena.RemoteDestroy(blocks[start], blocks[i - 1]);
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Empties the calling thread's cache if the manager was shut down since the
+  cache was last used. Its blocks are in pages that were released, handing
+  one out or flushing it to the arenas of a new MemoryManagerInit would use
+  memory the manager no longer owns
+******************************************************************************/
+void CheckCache(void)
+{
+  unsigned int generation = cacheGeneration.load(std::memory_order_acquire);
+
+  // if the cache was filled before the last shutdown
+  if (threadCache.generation != generation)
+  {
+    threadCache.Clear();
+    threadCache.generation = generation;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a block from the calling thread's cache without locking, an empty
+  cache list is refilled with a batch of blocks from the manager. Sizes too
+  big for the cache go straight to the manager
+
+\param size
+  the number of bytes to allocate
+
+\return
+  a pointer to the allocated memory
+******************************************************************************/
+void* CacheAllocate(size_t size)
+{
+  void* block;
+
+  Count(threadCache.stats.allocations);
+
+  // if the size is too big for the cache
+  if (size > CACHE_MAX_SIZE)
+  {
+    Count(threadCache.stats.uncached);
+
+    // if the size is big enough for a mapping of its own
+    if (size >= largeThreshold.load(std::memory_order_relaxed))
+    {
+      block = LargeAllocate(size, BIN_ALIGNMENT);
+    }
+    else
+    {
+      MemoryManager& arena = LockThreadArena();
+
+      block = arena.Allocate(size);
+      arena.Unlock();
+    }
+  }
+  else
+  {
+    size_t index = MemoryBins::ClassIndex(size);  // sizes up to SLAB_MAX_SIZE come from slabs, so no class is too small
+
+    CheckCache();
+    block = threadCache.Pop(index);
+
+    // if the cache list was empty
+    if (block == NULL)
+    {
+      void* blocks[CACHE_BATCH_SIZE];
+
+      Count(threadCache.stats.refills);
+
+      AllocateBatch(MemoryBins::ClassSize(index), CACHE_BATCH_SIZE, blocks);
+
+      // for all blocks but the one being returned
+      for (size_t i = 1; i < CACHE_BATCH_SIZE; ++i)
+      {
+        threadCache.Push(index, blocks[i]);
+      }
+
+      block = blocks[0];
+    }
+  }
+
+  Trace(MEMORY_TRACE_ALLOC, size, block);
+  Profile(size, block);
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Gives a block to the calling thread's cache without locking, a full cache
+  list sends a batch of blocks back to the manager. Blocks too big for the
+  cache go straight to the manager
+
+\param ptr
+  the block to destroy
+
+\param entry
+  the page map entry of the block, a slab object's size class comes from here
+******************************************************************************/
+void CacheDestroy(void* ptr, const PageMapEntry& entry)
+{
+  size_t index;
+
+  // if the arenas are shut down or already destroyed
+  if (!isInitialized)
+  {
+    return;
+  }
+
+  Count(threadCache.stats.frees);
+  Trace(MEMORY_TRACE_FREE, 0, ptr);
+  ProfileDestroy(ptr);
+
+  // if the block is an object in a slab
+  if (entry.slab)
+  {
+    index = entry.slab - 1;
+  }
+  else
+  {
+    MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(ptr);
+    size_t size = memoryAlloced->Size();
+
+    // if the block is too big for the cache
+    if (size > CACHE_MAX_SIZE)
+    {
+      // if the block has a mapping of its own
+      if (memoryAlloced->IsLarge())
+      {
+        LargeDestroy(ptr);
+      }
+      else
+      {
+        DestroyBatch(&ptr, 1);
+      }
+
+      return;
+    }
+
+    index = MemoryBins::FloorIndex(size);
+  }
+
+  CheckCache();
+  threadCache.Push(index, ptr);
+
+  // if the cache list is holding too many blocks
+  if (threadCache.Full(index))
+  {
+    threadCache.Flush(index, CACHE_BATCH_SIZE);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Gives a block of a known size to the calling thread's cache without reading
+  its header. Every block of a size the cache holds has at least the size of
+  that size's class, so it can go in that class's list whether it is a slab
+  object or not. The class it really belongs to is found when the cache flushes
+
+\param ptr
+  the block to destroy
+
+\param size
+  the size the block was allocated with
+******************************************************************************/
+void CacheDestroySized(void* ptr, size_t size)
+{
+  // if the block is too big for the cache
+  if (size > CACHE_MAX_SIZE)
+  {
+    CacheDestroy(ptr, pageMap.Find(ptr));
+    return;
+  }
+
+  // if the arenas are shut down or already destroyed
+  if (!isInitialized)
+  {
+    return;
+  }
+
+  size_t index = MemoryBins::ClassIndex(size);
+
+  Count(threadCache.stats.frees);
+  Trace(MEMORY_TRACE_FREE, size, ptr);
+  ProfileDestroy(ptr);
+  CheckCache();
+  threadCache.Push(index, ptr);
+
+  // if the cache list is holding too many blocks
+  if (threadCache.Full(index))
+  {
+    threadCache.Flush(index, CACHE_BATCH_SIZE);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Allocates from the system for operator new before the manager is ready,
+  operator delete hands anything outside the manager's pages back to free
+
+\param size
+  the number of bytes to allocate
+
+\return
+  a pointer to the allocated memory
+******************************************************************************/
+void* SystemAllocate(size_t size)
+{
+  void* memory = malloc(size);
+
+  // if the system is out of memory
+  if (memory == NULL)
+  {
+    throw std::bad_alloc();
+  }
+
+  return memory;
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a block in a system mapping of its own, no arena or lock is
+  involved and the mapping is unmapped as soon as the block is destroyed
+
+\param size
+  the number of bytes to allocate
+
+\param alignment
+  the power of two the block's address must be a multiple of
+
+\return
+  a pointer to the allocated memory
+******************************************************************************/
+void* LargeAllocate(size_t size, size_t alignment)
+{
+  size_t padding = (alignment > sizeof(MemoryAllocated)) ? alignment : sizeof(MemoryAllocated); // room for the header in front of the aligned block
+  size_t mapSize = (size + padding + PAGE_ALIGNMENT - 1) & ~(PAGE_ALIGNMENT - 1);
+  void* mapping = MemoryPageSource::MapDirect(mapSize);
+
+  // if the system is out of memory
+  if (mapping == NULL)
+  {
+    throw std::bad_alloc();
+  }
+
+  pageMap.InsertMapping(mapping, mapSize);
+
+  Count(threadCache.stats.largeMaps);
+  Count(threadCache.stats.largeMapped, mapSize);
+
+  uintptr_t memory = ((uintptr_t)(mapping) + sizeof(MemoryAllocated) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+  MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory((void*)(memory));
+
+  *memoryAlloced = MemoryAllocated((uintptr_t)(mapping) + mapSize - memory);  // the block runs to the end of the mapping
+  memoryAlloced->SetLarge(true);
+
+  return (void*)(memory);
+}
+
+/*!****************************************************************************
+\brief
+  Gives the mapping of a large block back to the system
+
+\param ptr
+  the block to destroy
+******************************************************************************/
+void LargeDestroy(void* ptr)
+{
+  char* mapping = (char*)(pageMap.MappingStart(ptr));
+  size_t mapSize = (char*)(ptr) + MemoryAllocated::FromMemory(ptr)->Size() - mapping;
+
+  pageMap.Erase(mapping, mapSize); // before unmapping, the range can be mapped again right away
+  MemoryPageSource::UnmapDirect(mapping, mapSize);
+
+  Count(threadCache.stats.largeUnmaps);
+  Count(threadCache.stats.largeUnmapped, mapSize);
+}
+
+/*!****************************************************************************
+\brief
+  Resizes the mapping of a large block without copying it, the block keeps
+  its offset into the mapping
+
+\param ptr
+  the block to resize
+
+\param size
+  the new size in bytes
+
+\return
+  the resized block, NULL if the system could not resize the mapping
+******************************************************************************/
+void* LargeRealloc(void* ptr, size_t size)
+{
+  char* mapping = (char*)(pageMap.MappingStart(ptr));
+  size_t offset = (char*)(ptr) - mapping;
+  size_t oldMapSize = offset + MemoryAllocated::FromMemory(ptr)->Size();
+  size_t newMapSize = (offset + size + PAGE_ALIGNMENT - 1) & ~(PAGE_ALIGNMENT - 1);
+
+  // if the mapping is already the right size
+  if (oldMapSize == newMapSize)
+  {
+    return ptr;
+  }
+
+  pageMap.Erase(mapping, oldMapSize);
+
+  char* newMapping = (char*)(MemoryPageSource::RemapDirect(mapping, oldMapSize, newMapSize));
+
+  // if the mapping could not be resized
+  if (newMapping == NULL)
+  {
+    pageMap.InsertMapping(mapping, oldMapSize);
+    return NULL;
+  }
+
+  pageMap.InsertMapping(newMapping, newMapSize);
+
+  // if the mapping grew
+  if (newMapSize > oldMapSize)
+  {
+    Count(threadCache.stats.largeMapped, newMapSize - oldMapSize);
+  }
+  else
+  {
+    Count(threadCache.stats.largeUnmapped, oldMapSize - newMapSize);
+  }
+
+  MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(newMapping + offset);
+  memoryAlloced->SetSize(newMapSize - offset);
+
+  return memoryAlloced->Memory();
+}
+
+/*!****************************************************************************
+\brief
+  Gets the time decay is measured in, it only ever moves forward
+
+\return
+  the time in milliseconds
+******************************************************************************/
+uint64_t CurrentTime(void)
+{
+  return (uint64_t)(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/*!****************************************************************************
+\brief
+  Purges the idle pages of every arena in turn, each arena is locked on its
+  own so only one waits on the system at a time
+
+\param minIdle
+  the milliseconds a page must have been wholly free to be purged
+
+\param limit
+  the number of bytes to stop after
+
+\return
+  the number of bytes given back to the system
+******************************************************************************/
+size_t PurgeArenas(uint64_t minIdle, size_t limit)
+{
+  size_t purged = 0;
+
+  // for all arenas in use while there is more to purge
+  for (unsigned int i = 0; i < arenaCount && purged < limit; ++i)
+  {
+    MemoryManager& arena = LockArena(i);
+
+    purged += arena.Purge(CurrentTime(), minIdle, limit - purged);
+    arena.Unlock();
+  }
+
+  return purged;
+}
+
+/*!****************************************************************************
+\brief
+  Changes every setting the arenas grow with, a page size is rounded up to
+  whole granules
+
+\param config
+  the settings to use
+******************************************************************************/
+void SetConfig(const MemoryConfig& config)
+{
+  size_t totalSize = (config.pageSize + PAGE_ALIGNMENT - 1) & ~(PAGE_ALIGNMENT - 1);
+
+  // if the page would not fill a single granule
+  if (totalSize < PAGE_ALIGNMENT)
+  {
+    totalSize = PAGE_ALIGNMENT;
+  }
+
+  pageSize.store(totalSize - 2 * sizeof(MemoryAllocated), std::memory_order_relaxed);
+  initialPages.store(config.initialPages, std::memory_order_relaxed);
+  pageGrowth.store(config.pageGrowth, std::memory_order_relaxed);
+  largeThreshold.store(config.largeThreshold, std::memory_order_relaxed);
+  decayTime.store(config.decayTime, std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Changes the default settings to the ones given in environment variables,
+  run once before the first allocation. A variable that is not set or can
+  not be read leaves its setting alone. A trace is started if MEMORY_TRACE
+  names a file
+******************************************************************************/
+void ReadEnvironment(void)
+{
+  MemoryConfig config;
+
+  MemoryManagerGetConfig(config);
+
+  ReadSize("MEMORY_PAGE_SIZE", config.pageSize);
+  ReadSize("MEMORY_INITIAL_PAGES", config.initialPages);
+  ReadSize("MEMORY_PAGE_GROWTH", config.pageGrowth);
+  ReadSize("MEMORY_LARGE_THRESHOLD", config.largeThreshold);
+
+  const char* decay = getenv("MEMORY_DECAY_TIME");
+
+  // if pages should never decay
+  if (decay && strcmp(decay, "never") == 0)
+  {
+    config.decayTime = MEMORY_DECAY_NEVER;
+  }
+  else
+  {
+    ReadSize("MEMORY_DECAY_TIME", config.decayTime);
+  }
+
+  SetConfig(config);
+
+  const char* trace = getenv("MEMORY_TRACE");
+
+  // if the whole run of the program should be traced
+  if (trace && *trace)
+  {
+    size_t traceSize = MEMORY_TRACE_SIZE;
+
+    ReadSize("MEMORY_TRACE_SIZE", traceSize);
+    memoryTrace.Start(trace, traceSize);
+  }
+
+  const char* profile = getenv("MEMORY_PROFILE");
+
+  // if the whole run of the program should be profiled
+  if (profile && *profile)
+  {
+    size_t rate = MEMORY_PROFILE_RATE;
+
+    ReadSize("MEMORY_PROFILE_RATE", rate);
+    memoryProfile.DumpOnExit(profile);
+    memoryProfile.Start(rate);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Reads a number from an environment variable, a K, M or G suffix multiplies
+  it by 1024 once, twice or three times
+
+\param name
+  the name of the variable
+
+\param value
+  set to the number if the variable holds one
+
+\return
+  true if the variable was read, else false
+******************************************************************************/
+bool ReadSize(const char* name, size_t& value)
+{
+  const char* text = getenv(name);
+
+  // if the variable is not set
+  if (text == NULL || *text == '\0')
+  {
+    return false;
+  }
+
+  char* end;
+  unsigned long long number = strtoull(text, &end, 10);
+
+  // if the number has a suffix
+  switch (*end)
+  {
+    case 'G': case 'g':
+      number *= 1024;
+      // fall through
+    case 'M': case 'm':
+      number *= 1024;
+      // fall through
+    case 'K': case 'k':
+      number *= 1024;
+      ++end;
+      break;
+  }
+
+  // if anything but a number was given
+  if (end == text || *end != '\0')
+  {
+    return false;
+  }
+
+  value = (size_t)(number);
+
+  return true;
+}
+
+/*!****************************************************************************
+\brief
+  Adds to a counter only the calling thread writes, a plain load and store
+  so the add does not lock the cache line
+
+\param counter
+  the counter to add to
+
+\param amount
+  the amount to add
+******************************************************************************/
+void Count(std::atomic<size_t>& counter, size_t amount)
+{
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Adds the counters of one thread to a set of statistics, statsLock must
+  already be held
+
+\param stats
+  the statistics to add to
+
+\param threadStats
+  the counters of the thread
+******************************************************************************/
+void AddThreadStats(MemoryStats& stats, const ThreadStats& threadStats)
+{
+  size_t allocations = threadStats.allocations.load(std::memory_order_relaxed);
+  size_t refills = threadStats.refills.load(std::memory_order_relaxed);
+  size_t uncached = threadStats.uncached.load(std::memory_order_relaxed);
+
+  stats.allocations += allocations;
+  stats.frees += threadStats.frees.load(std::memory_order_relaxed);
+  stats.cacheHits += allocations - refills - uncached;
+  stats.cacheRefills += refills;
+  stats.cacheFlushes += threadStats.flushes.load(std::memory_order_relaxed);
+  stats.largeBlocks += threadStats.largeMaps.load(std::memory_order_relaxed) - threadStats.largeUnmaps.load(std::memory_order_relaxed);
+  stats.largeBytes += threadStats.largeMapped.load(std::memory_order_relaxed) - threadStats.largeUnmapped.load(std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Records an allocation or free if a trace is running, a single relaxed load
+  while it is not
+
+\param op
+  what happened to the block
+
+\param size
+  the bytes asked for, 0 if they are not known
+
+\param ptr
+  the block
+******************************************************************************/
+void Trace(MemoryTraceOp op, size_t size, const void* ptr)
+{
+  // if a trace is running
+  if (memoryTrace.Enabled())
+  {
+    memoryTrace.Record(op, size, ptr);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Samples an allocation for the heap profile if one is running, a single load
+  while it is not
+
+\param size
+  the bytes asked for
+
+\param ptr
+  the block
+******************************************************************************/
+void Profile(size_t size, const void* ptr)
+{
+  // if a profile is running
+  if (memoryProfile.Enabled())
+  {
+    memoryProfile.Allocated(size, ptr);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Lets the heap profile forget a block being freed if one is running
+
+\param ptr
+  the block
+******************************************************************************/
+void ProfileDestroy(const void* ptr)
+{
+  // if a profile is running
+  if (memoryProfile.Enabled())
+  {
+    memoryProfile.Destroyed(ptr);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Records a block Realloc resized without going through Alloc and Delete as
+  a free of the old block and an allocation of the new one, so a replay sees
+  its new size even when it did not move and the profile samples it again
+
+\param ptr
+  the block before it was resized
+
+\param memory
+  the block after it was resized
+
+\param size
+  the new size in bytes
+******************************************************************************/
+void RecordResize(const void* ptr, const void* memory, size_t size)
+{
+  Trace(MEMORY_TRACE_FREE, 0, ptr);
+  Trace(MEMORY_TRACE_ALLOC, size, memory);
+  ProfileDestroy(ptr);
+  Profile(size, memory);
+}
+
+/*!****************************************************************************
+\brief
+  Records the blocks of a batch from AllocBatch as allocations in the trace
+  and the heap profile, the blocks skip the thread cache that records the
+  others
+
+\param size
+  the bytes asked for each block
+
+\param blocks
+  the blocks, NULL entries are skipped
+
+\param count
+  the number of pointers in blocks
+******************************************************************************/
+void RecordBatch(size_t size, void* const* blocks, size_t count)
+{
+  // for all blocks
+  for (size_t i = 0; i < count; ++i)
+  {
+    // if the block was allocated
+    if (blocks[i])
+    {
+      Trace(MEMORY_TRACE_ALLOC, size, blocks[i]);
+      Profile(size, blocks[i]);
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Runs in the child after a fork. The child shares the parent's trace file
+  but not its count of the runs claimed, so it stops recording and leaves
+  the file to the parent
+******************************************************************************/
+void DetachTrace(void)
+{
+  memoryTrace.Detach();
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: ThreadCache
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Picks the thread's first arena and links the cache into threadCaches
+******************************************************************************/
+ThreadCache::ThreadCache(void) :
+  arena(nextArena.fetch_add(1, std::memory_order_relaxed) % arenaCount),
+  generation(cacheGeneration.load(std::memory_order_acquire)),
+  stats(),
+  prev(NULL),
+  next(NULL)
+{
+  std::lock_guard<std::mutex> lock(statsLock);
+
+  next = threadCaches;
+
+  // if another thread is already linked
+  if (next)
+  {
+    next->prev = this;
+  }
+
+  threadCaches = this;
+}
+
+/*!****************************************************************************
+\brief
+  Returns every block in the cache to the manager when the thread exits, its
+  counters are kept in retiredStats
+******************************************************************************/
+ThreadCache::~ThreadCache(void)
+{
+  // if the manager still owns its pages and the cache's blocks are in them
+  if (isInitialized && generation == cacheGeneration.load(std::memory_order_acquire))
+  {
+    // for all size classes
+    for (size_t i = 0; i < CACHE_CLASS_COUNT; ++i)
+    {
+      // while the list has blocks
+      while (!Empty(i))
+      {
+        Flush(i, CACHE_BATCH_SIZE);
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(statsLock);
+
+  Count(retiredStats.allocations, stats.allocations.load(std::memory_order_relaxed));
+  Count(retiredStats.frees, stats.frees.load(std::memory_order_relaxed));
+  Count(retiredStats.uncached, stats.uncached.load(std::memory_order_relaxed));
+  Count(retiredStats.refills, stats.refills.load(std::memory_order_relaxed));
+  Count(retiredStats.flushes, stats.flushes.load(std::memory_order_relaxed));
+  Count(retiredStats.largeMaps, stats.largeMaps.load(std::memory_order_relaxed));
+  Count(retiredStats.largeUnmaps, stats.largeUnmaps.load(std::memory_order_relaxed));
+  Count(retiredStats.largeMapped, stats.largeMapped.load(std::memory_order_relaxed));
+  Count(retiredStats.largeUnmapped, stats.largeUnmapped.load(std::memory_order_relaxed));
+
+  // if a thread is linked before this one
+  if (prev)
+  {
+    prev->next = next;
+  }
+  else
+  {
+    threadCaches = next;
+  }
+
+  // if a thread is linked after this one
+  if (next)
+  {
+    next->prev = prev;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Sends up to a given number of blocks from a size class back to the manager
+  under a single lock
+
+\param index
+  the size class to flush
+
+\param count
+  the most blocks to send back
+******************************************************************************/
+void ThreadCache::Flush(size_t index, size_t count)
+{
+  void* blocks[CACHE_BATCH_SIZE];
+  size_t found = 0;
+
+  // while there are blocks to send back
+  while (found < count && found < CACHE_BATCH_SIZE && !Empty(index))
+  {
+    blocks[found++] = Pop(index);
+  }
+
+  Count(stats.flushes);
+
+  DestroyBatch(blocks, found);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: PurgeThread
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+PurgeThread::PurgeThread(void) :
+  mThread(),
+  mLock(),
+  mWake(),
+  mRunning(false)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Stops the thread before the arenas it purges are destroyed
+******************************************************************************/
+PurgeThread::~PurgeThread(void)
+{
+  Stop();
+}
+
+/*!****************************************************************************
+\brief
+  Starts the thread if it is not already running
+******************************************************************************/
+void PurgeThread::Start(void)
+{
+  std::lock_guard<std::mutex> lock(mLock);
+
+  // if the thread is already running
+  if (mThread.joinable())
+  {
+    return;
+  }
+
+  mRunning = true;
+  mThread = std::thread(&PurgeThread::Run, this);
+}
+
+/*!****************************************************************************
+\brief
+  Wakes the thread, waits for it to finish its pass and exit
+******************************************************************************/
+void PurgeThread::Stop(void)
+{
+  std::thread thread;
+
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mRunning = false;
+    thread = std::move(mThread);
+  }
+
+  mWake.notify_all();
+
+  // if the thread was running
+  if (thread.joinable())
+  {
+    thread.join();
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Runs a decay pass over every arena a quarter of the decay time apart, at
+  least once a second so a shorter decay time set later is picked up
+******************************************************************************/
+void PurgeThread::Run(void)
+{
+  std::unique_lock<std::mutex> lock(mLock);
+
+  // while the thread has not been stopped
+  while (mRunning)
+  {
+    size_t decay = decayTime.load(std::memory_order_relaxed);
+    size_t interval = (decay == MEMORY_DECAY_NEVER) ? 1000 : decay / 4;
+
+    interval = (interval < 1) ? 1 : ((interval > 1000) ? 1000 : interval);
+
+    // if the thread was stopped while it waited
+    if (mWake.wait_for(lock, std::chrono::milliseconds(interval), [this] { return !mRunning; }))
+    {
+      break;
+    }
+
+    // if pages are allowed to decay
+    if (decay != MEMORY_DECAY_NEVER)
+    {
+      lock.unlock();
+      PurgeArenas(decay, SIZE_MAX);
+      lock.lock();
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: ExitGuard
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+ExitGuard::~ExitGuard(void)
+{
+  isInitialized = false;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryManager
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  A default constructor for a memoryManager, starts with 10 pages
+******************************************************************************/
+MemoryManager::MemoryManager(void) :
+  mContention(0),
+  mRemoteFrees(NULL),
+  mHeap(),
+  mPageVec(0),
+  mFreeBins(),
+  mSource(),
+  mSlabVec(0),
+  mSlabLists(),
+  mFreeSlabs(0),
+  mLentSlabs(0),
+  mPurgedCount(0),
+  mLastPurge(0),
+  mPurgeDue(false),
+  mBinHits(0),
+  mHeapHits(0),
+  mNewPages(0)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Allocates all pages and initializes the heap of the memory manager, the lock
+  must already be held
+******************************************************************************/
+void MemoryManager::Init(void)
+{
+  size_t count = initialPages.load(std::memory_order_relaxed);
+  size_t size = pageSize.load(std::memory_order_relaxed);
+
+  // for all pages in the manager
+  for (size_t i = 0; i < count; ++i)
+  {
+    MemoryBlock temp = AllocatePage(size);  // allocate a new page
+
+    AddBlockToFree(temp); // insert new block into the free bins
+  }
+
+  GetHeapFromFreeMap(0); // get the heap
+}
+
+/*!****************************************************************************
+\brief
+  frees all dynamic MemoryManager memory, the lock must already be held. The
+  arena is left empty and can be used again
+******************************************************************************/
+void MemoryManager::Shutdown(void)
+{
+  size_t size = mPageVec.size();
+
+  // for all allocated pages in manager
+  for (size_t i = 0; i < size; ++i)
+  {
+    pageMap.Erase(mPageVec[i].Ptr(), mPageVec[i].Size() + 2 * sizeof(MemoryAllocated));
+  }
+
+  // for all slab pages in manager
+  for (const MemorySlab& slab : mSlabVec)
+  {
+    pageMap.Erase(slab.Ptr(), slab.Size());
+  }
+
+  mSource.Release();  // free every page at once
+
+  mPageVec.clear();
+  mSlabVec.clear();
+  memset(mSlabLists, 0, sizeof(mSlabLists));
+  mFreeSlabs = 0;
+  mLentSlabs = 0;
+  mPurgedCount = 0;
+  mPurgeDue = false;
+  mHeap = MemoryBlock();
+  mFreeBins = MemoryBins();
+  mRemoteFrees.store(NULL, std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a given size in bytes, the lock must already be held. Small sizes
+  are objects in a slab with no header, everything else is a block with one
+
+\param memSize
+  the number of bytes to be allocated
+
+\return
+  a pointer to the memory allocated
+******************************************************************************/
+void* MemoryManager::Allocate(size_t memSize)
+{
+  DrainRemoteFrees(); // take back blocks other threads freed since the last allocation
+
+  // if the size fits in a slab size class
+  if (memSize <= SLAB_MAX_SIZE)
+  {
+    return AllocateSlab(MemoryBins::ClassIndex(memSize));
+  }
+
+  return AllocateBlock(memSize);
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a given size in bytes, the lock must already be held
+
+\param memSize
+  the number of bytes to be allocated
+
+\return
+  a pointer to the memory allocated
+******************************************************************************/
+void* MemoryManager::AllocateBlock(size_t memSize)
+{
+  memSize = (memSize + BIN_ALIGNMENT - 1) & ~(BIN_ALIGNMENT - 1);
+
+  // if the size is too small to be freed later
+  if (memSize < MIN_BLOCK_SIZE)
+  {
+    memSize = MIN_BLOCK_SIZE;
+  }
+
+  void* mem = mFreeBins.PopFit(memSize);  // the smallest free block that fits
+
+  // if a free block was found
+  if (mem)
+  {
+    UseBlock(mem);
+    SplitBlock(mem, memSize); // give back what was not asked for
+    ++mBinHits;
+  }
+  else
+  {
+    mem = AllocateMemoryFromHeap(memSize);
+
+    // if we could not allocate from the heap
+    if (mem == NULL)
+    {
+      AddBlockToFree(mHeap);
+      mHeap = MemoryBlock();
+      mHeap = GrowHeap(memSize);
+      ++mNewPages;
+
+      mem = AllocateMemoryFromHeap(memSize);  // allocate memory
+    }
+    else
+    {
+      ++mHeapHits;
+    }
+  }
+
+  MemoryAllocated::FromMemory(mem)->SetOwner(index); // the block has to come back to this arena
+
+  return mem;
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a block whose address is a multiple of a given alignment, the
+  lock must already be held. A block with room for the alignment is taken
+  and the padding in front of the aligned address is freed as a block of its
+  own, the same as the unused tail
+
+\param memSize
+  the number of bytes to be allocated
+
+\param alignment
+  the power of two the block's address must be a multiple of
+
+\return
+  a pointer to the memory allocated
+******************************************************************************/
+void* MemoryManager::AllocateAligned(size_t memSize, size_t alignment)
+{
+  // if every block is already aligned enough
+  if (alignment <= BIN_ALIGNMENT)
+  {
+    return Allocate(memSize);
+  }
+
+  memSize = (memSize + BIN_ALIGNMENT - 1) & ~(BIN_ALIGNMENT - 1);
+
+  // if the size is too small to be freed later
+  if (memSize < MIN_BLOCK_SIZE)
+  {
+    memSize = MIN_BLOCK_SIZE;
+  }
+
+  DrainRemoteFrees();
+
+  char* mem = (char*)(AllocateBlock(memSize + alignment + sizeof(MemoryAllocated) + MIN_BLOCK_SIZE)); // room for the worst padding, never a slab object
+  char* aligned = (char*)(((uintptr_t)(mem) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+
+  // if the block is not aligned already
+  if (aligned != mem)
+  {
+    // while the padding is too small to be a free block
+    while ((size_t)(aligned - mem) < sizeof(MemoryAllocated) + MIN_BLOCK_SIZE)
+    {
+      aligned += alignment;
+    }
+
+    MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(mem);
+    MemoryAllocated* alignedAlloced = MemoryAllocated::FromMemory(aligned);
+    size_t padding = aligned - mem - sizeof(MemoryAllocated);
+
+    *alignedAlloced = MemoryAllocated(memoryAlloced->Size() - padding - sizeof(MemoryAllocated));
+    alignedAlloced->SetOwner(index);
+
+    memoryAlloced->SetSize(padding);
+    FreeBlock(memoryAlloced); // the padding goes back to the bins or the heap
+
+    mem = aligned;
+  }
+
+  SplitBlock(mem, memSize); // give back what was not asked for
+
+  return mem;
+}
+
+/*!****************************************************************************
+\brief
+  Destroys a given pointer in the manager, the lock must already be held. A
+  slab object goes back to its slab, a block is merged with any free blocks
+  directly before or after it in memory
+
+\param ptr
+  the address of the MemoryBlock to destroy
+******************************************************************************/
+void MemoryManager::Destroy(void* ptr)
+{
+  PageMapEntry entry = pageMap.Find(ptr);
+
+  // if the pointer is an object in a slab
+  if (entry.slab)
+  {
+    DestroySlab(ptr, entry);
+  }
+  else
+  {
+    FreeBlock(MemoryAllocated::FromMemory(ptr));
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a number of blocks of the same size. Sizes that fit a slab are
+  taken as contiguous runs of slab objects, bigger blocks are split out of
+  one free block per page worth of blocks instead of searching the bins for
+  each one
+
+\param memSize
+  the number of bytes in each block
+
+\param count
+  the number of blocks to allocate
+
+\param blocks
+  filled with the allocated blocks, must hold count pointers
+******************************************************************************/
+void MemoryManager::AllocateRun(size_t memSize, size_t count, void** blocks)
+{
+  DrainRemoteFrees();
+
+  // if the size fits in a slab size class
+  if (memSize <= SLAB_MAX_SIZE)
+  {
+    AllocateSlabRun(MemoryBins::ClassIndex(memSize), count, blocks);
+    return;
+  }
+
+  memSize = (memSize + BIN_ALIGNMENT - 1) & ~(BIN_ALIGNMENT - 1);
+
+  size_t stride = memSize + sizeof(MemoryAllocated);
+  size_t runCount = (MemoryBins::ClassSize(MemoryBins::FloorIndex(pageSize.load(std::memory_order_relaxed))) + sizeof(MemoryAllocated)) / stride; // a run a whole free page can be found for
+
+  // if a single block is bigger than a page
+  if (runCount == 0)
+  {
+    runCount = 1;
+  }
+
+  // while there are blocks left to allocate
+  while (count)
+  {
+    size_t blockCount = (count < runCount) ? count : runCount;
+    MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(AllocateBlock(blockCount * stride - sizeof(MemoryAllocated)));
+    size_t rest = memoryAlloced->Size();
+
+    // for all blocks but the last, which keeps whatever is left over
+    for (size_t i = 0; i + 1 < blockCount; ++i)
+    {
+      memoryAlloced->SetSize(memSize);
+      *blocks++ = memoryAlloced->Memory();
+      rest -= stride;
+
+      memoryAlloced = memoryAlloced->Next();
+      *memoryAlloced = MemoryAllocated(rest);
+      memoryAlloced->SetOwner(index);
+    }
+
+    *blocks++ = memoryAlloced->Memory();
+    count -= blockCount;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Destroys a number of blocks owned by this arena. Objects next to each other
+  in the list that share a slab are chained together and given back with one
+  update of the slab's free list. A decay pass runs afterwards if one is due
+
+\param blocks
+  the blocks to destroy, sorting them by address groups each slab's objects
+
+\param count
+  the number of blocks
+******************************************************************************/
+void MemoryManager::DestroyRun(void** blocks, size_t count)
+{
+  size_t i = 0;
+
+  // while there are blocks left to destroy
+  while (i < count)
+  {
+    PageMapEntry entry = pageMap.Find(blocks[i]);
+
+    // if the block is not a slab object
+    if (entry.slab == 0)
+    {
+      FreeBlock(MemoryAllocated::FromMemory(blocks[i++]));
+      continue;
+    }
+
+    size_t start = i++;
+
+    // while the following objects are in the same slab
+    while (i < count)
+    {
+      PageMapEntry next = pageMap.Find(blocks[i]);
+
+      // if the object is in another slab
+      if (next.slab == 0 || next.page != entry.page)
+      {
+        break;
+      }
+
+      *(void**)(blocks[i - 1]) = blocks[i]; // chain the run together through the user memory
+      ++i;
+    }
+
+    DestroySlabList(blocks[start], blocks[i - 1], i - start, entry);
+  }
+
+  // if a page is waiting to decay
+  if (mPurgeDue)
+  {
+    size_t decay = decayTime.load(std::memory_order_relaxed);
+    uint64_t now = CurrentTime();
+
+    // if the last pass was at least a quarter of the decay time ago
+    if (decay != MEMORY_DECAY_NEVER && now - mLastPurge >= decay / 4)
+    {
+      Purge(now, decay, SIZE_MAX);
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Changes the size of an in use block without moving it, the lock must
+  already be held. A smaller block gives its tail back, a bigger block takes
+  what it needs from a free block or the heap directly after it
+
+\param ptr
+  the block to resize
+
+\param memSize
+  the number of bytes the block should have
+
+\return
+  true if the block now has at least memSize bytes, false if the space after
+  it was not free or not big enough
+******************************************************************************/
+bool MemoryManager::Resize(void* ptr, size_t memSize)
+{
+  memSize = (memSize + BIN_ALIGNMENT - 1) & ~(BIN_ALIGNMENT - 1);
+
+  // if the size is too small to be freed later
+  if (memSize < MIN_BLOCK_SIZE)
+  {
+    memSize = MIN_BLOCK_SIZE;
+  }
+
+  MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(ptr);
+  size_t size = memoryAlloced->Size();
+  MemoryAllocated* next = memoryAlloced->Next();
+
+  // if the block is shrinking
+  if (memSize <= size)
+  {
+    SplitBlock(ptr, memSize); // the tail merges with whatever is free after it
+    return true;
+  }
+
+  // if the block after this one is free and big enough to grow into
+  if (next->IsFree() && size + sizeof(MemoryAllocated) + next->Size() >= memSize)
+  {
+    mFreeBins.Remove(next->Memory(), MemoryBins::FloorIndex(next->Size()));
+
+    memoryAlloced->SetSize(size + sizeof(MemoryAllocated) + next->Size());
+    memoryAlloced->Next()->SetPrevFree(false);
+
+    SplitBlock(ptr, memSize);
+    return true;
+  }
+
+  // if the heap starts right after this block and is big enough to grow into
+  if (next->Memory() == mHeap.MemoryLocation() && size + sizeof(MemoryAllocated) + mHeap.Size() >= memSize)
+  {
+    size_t needed = memSize - size;
+    size_t heapSize = sizeof(MemoryAllocated) + mHeap.Size(); // the heap with its header
+
+    // if what is left of the heap would be too small to free later
+    if (heapSize - needed < sizeof(MemoryAllocated) + MIN_BLOCK_SIZE)
+    {
+      memoryAlloced->SetSize(size + heapSize);  // take the whole heap
+      mHeap = MemoryBlock();
+    }
+    else
+    {
+      memoryAlloced->SetSize(memSize);
+      MoveBlock(mHeap, needed, true); // the heap header moves to just after the grown block
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether a pointer is inside one of this arena's pages, safe to call
+  without the lock
+
+\param ptr
+  the pointer to check
+
+\return
+  true if the arena owns the pointer, else false
+******************************************************************************/
+bool MemoryManager::Owns(const void* ptr) const
+{
+  PageMapEntry entry = pageMap.Find(ptr);
+
+  return entry.page != 0 && entry.arena == index;
+}
+
+/*!****************************************************************************
+\brief
+  Hands a chain of blocks back to the arena without taking its lock, the
+  blocks are really freed during the arena's next allocation. Safe to call
+  from any number of threads at once
+
+\param first
+  the first block of the chain
+
+\param last
+  the last block of the chain, every block before it holds a pointer to the
+  next block in its first bytes
+******************************************************************************/
+void MemoryManager::RemoteDestroy(void* first, void* last)
+{
+  void* head = mRemoteFrees.load(std::memory_order_relaxed);
+
+  // while another thread changed the list before we could
+  do
+  {
+    *(void**)(last) = head;  // link the chain in front of the current list
+  } while (!mRemoteFrees.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+/*!****************************************************************************
+\brief
+  Counts the resident bytes in whole free pages and empty slabs, the memory a
+  decay pass or Trim could give back, the lock must already be held. Blocks
+  other threads freed into the arena are taken back first
+
+\return
+  the number of idle bytes that have not been purged
+******************************************************************************/
+size_t MemoryManager::IdleBytes(void)
+{
+  size_t idle = 0;
+
+  DrainRemoteFrees();
+
+  // for all pages
+  for (const MemoryPage& page : mPageVec)
+  {
+    const MemoryAllocated* memoryAlloced = (const MemoryAllocated*)(page.Ptr());
+
+    // if the page is resident and wholly free, the heap's header is never marked free
+    if (!page.IsPurged() && !page.IsLent() && memoryAlloced->IsFree() && memoryAlloced->Size() == page.Size())
+    {
+      idle += page.Size() + 2 * sizeof(MemoryAllocated);
+    }
+  }
+
+  // for all slab pages
+  for (const MemorySlab& slab : mSlabVec)
+  {
+    // if the slab is resident and empty
+    if (!slab.purged && !slab.lent && slab.Empty())
+    {
+      idle += slab.Size();
+    }
+  }
+
+  return idle;
+}
+
+/*!****************************************************************************
+\brief
+  Gives the memory of whole free pages and empty slabs that have been idle
+  long enough back to the system, the lock must already be held. A purged
+  page leaves the bins until AllocatePage takes it again, an empty slab stays
+  on its list since its objects are carved again from the start
+
+\param now
+  the current time in milliseconds
+
+\param minIdle
+  the milliseconds a page or slab must have been wholly free
+
+\param limit
+  the number of bytes to stop after
+
+\return
+  the number of bytes given back to the system
+******************************************************************************/
+size_t MemoryManager::Purge(uint64_t now, uint64_t minIdle, size_t limit)
+{
+  size_t purged = 0;
+  bool waiting = false; // true if an idle page is left resident
+
+  mLastPurge = now;
+
+  // for all pages while there is more to purge
+  for (size_t i = 0; i < mPageVec.size() && purged < limit; ++i)
+  {
+    MemoryPage& page = mPageVec[i];
+    MemoryAllocated* memoryAlloced = (MemoryAllocated*)(const_cast<void*>(page.Ptr()));
+
+    // if the page is purged already, a slab or in use
+    if (page.IsPurged() || page.IsLent() || !memoryAlloced->IsFree() || memoryAlloced->Size() != page.Size())
+    {
+      continue;
+    }
+
+    // if the page went idle too recently
+    if (now < page.IdleSince() || now - page.IdleSince() < minIdle)
+    {
+      waiting = true;
+      continue;
+    }
+
+    size_t totalSize = page.Size() + 2 * sizeof(MemoryAllocated);
+
+    mFreeBins.Remove(memoryAlloced->Memory(), MemoryBins::FloorIndex(page.Size()));
+
+    // if the system refused the pages, they stay resident and are not
+    // tried again until they have been idle for another decay time
+    if (!MemoryPageSource::Purge(memoryAlloced, totalSize))
+    {
+      mFreeBins.Push(memoryAlloced->Memory(), page.Size());  // put the block back
+      page.SetIdleSince(now);
+      continue;
+    }
+
+    page.SetPurged(true);
+    ++mPurgedCount;
+    purged += totalSize;
+  }
+
+  // for all slab pages while there is more to purge
+  for (size_t i = 0; i < mSlabVec.size() && purged < limit; ++i)
+  {
+    MemorySlab& slab = mSlabVec[i];
+
+    // if the slab is purged already, a page of blocks or in use
+    if (slab.purged || slab.lent || !slab.Empty())
+    {
+      continue;
+    }
+
+    // if the slab went idle too recently
+    if (now < slab.idleSince || now - slab.idleSince < minIdle)
+    {
+      waiting = true;
+      continue;
+    }
+
+    // if the system refused the pages, try again after another decay time
+    if (!MemoryPageSource::Purge(const_cast<void*>(slab.Ptr()), slab.Size()))
+    {
+      slab.idleSince = now;
+      continue;
+    }
+
+    slab.purged = true;
+    purged += slab.Size();
+  }
+
+  mPurgeDue = waiting || purged >= limit; // a pass stopped by the limit may have left pages behind
+
+  return purged;
+}
+
+/*!****************************************************************************
+\brief
+  Adds the arena's counters and the memory of its pages, slabs and bins to a
+  set of statistics, the lock must already be held. Every bin is walked, so
+  this is only for GetStats
+
+\param stats
+  the statistics to add to, largestFree is raised to the arena's biggest
+  free block
+
+\param largest
+  raised to the biggest free block in the bins or the heap that is not a
+  whole page
+
+\return
+  the bytes free in the bins and the heap, leaving out free slab objects and
+  pages that are wholly free, they are not fragmented
+******************************************************************************/
+size_t MemoryManager::AddStats(MemoryStats& stats, size_t& largest)
+{
+  size_t blockBytes = mHeap.Size();
+  size_t wholeBytes = 0;  // free in blocks that cover their whole page
+
+  DrainRemoteFrees();
+
+  stats.binHits += mBinHits;
+  stats.heapHits += mHeapHits;
+  stats.newPages += mNewPages;
+  // for all pages
+  for (const MemoryPage& page : mPageVec)
+  {
+    size_t totalSize = page.Size() + 2 * sizeof(MemoryAllocated);
+
+    // if the page's memory is a slab, it is counted with the slabs
+    if (page.IsLent())
+    {
+      continue;
+    }
+
+    ++stats.pages;
+
+    // if the system has the page back
+    if (page.IsPurged())
+    {
+      stats.purgedBytes += totalSize;
+    }
+    else
+    {
+      stats.pageBytes += totalSize;
+    }
+  }
+
+  // for all slab pages
+  for (const MemorySlab& slab : mSlabVec)
+  {
+    // if the slab's memory is a page of blocks, it is counted with the pages
+    if (slab.lent)
+    {
+      continue;
+    }
+
+    ++stats.slabs;
+
+    // if the system has the slab back, a purged slab that was used again is
+    // only marked resident once it is empty
+    if (slab.purged && slab.Empty())
+    {
+      stats.purgedBytes += slab.Size();
+    }
+    else
+    {
+      stats.slabBytes += slab.Size();
+      stats.freeBytes += slab.Size() - slab.Used() * slab.ObjectSize();
+    }
+  }
+
+  largest = (mHeap.Size() > largest) ? mHeap.Size() : largest;
+
+  // for all free bins
+  for (size_t i = 0; i < BIN_COUNT; ++i)
+  {
+    // for all blocks in the bin
+    for (void* block = mFreeBins.First(i); block; block = MemoryBins::Next(block))
+    {
+      MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(block);
+      size_t size = memoryAlloced->Size();
+
+      stats.binFreeBytes[i] += size;
+      blockBytes += size;
+      stats.largestFree = (size > stats.largestFree) ? size : stats.largestFree;
+
+      // if the block ends at a page's fence, so it could cover the whole page
+      if (memoryAlloced->Next()->Size() == 0)
+      {
+        const MemoryPage& page = mPageVec[pageMap.Find(memoryAlloced).page - 1];
+
+        // if the block is the whole page
+        if (page.Ptr() == memoryAlloced && page.Size() == size)
+        {
+          wholeBytes += size;
+          continue;
+        }
+      }
+
+      largest = (size > largest) ? size : largest;
+    }
+  }
+
+  stats.freeBytes += blockBytes;
+  stats.largestFree = (mHeap.Size() > stats.largestFree) ? mHeap.Size() : stats.largestFree;
+
+  return blockBytes - wholeBytes;
+}
+
+/*!****************************************************************************
+\brief
+  Takes the lock if no other thread holds it, a failed attempt is counted as
+  contention
+
+\return
+  true if the lock was taken, else false
+******************************************************************************/
+bool MemoryManager::TryLock(void)
+{
+  // if the lock was free
+  if (mLock.try_lock())
+  {
+    return true;
+  }
+
+  mContention.fetch_add(1, std::memory_order_relaxed);
+
+  return false;
+}
+
+void MemoryManager::Lock(void)
+{
+  mLock.lock();
+}
+
+void MemoryManager::Unlock(void)
+{
+  mLock.unlock();
+}
+
+size_t MemoryManager::Contention(void) const
+{
+  return mContention.load(std::memory_order_relaxed);
+}
+
+MemoryManager& MemoryManager::operator=(const MemoryManager& rhs)
+{
+  mHeap = rhs.mHeap;
+  mFreeBins = rhs.mFreeBins;
+  mPageVec = rhs.mPageVec;
+  mSource = rhs.mSource;
+  mSlabVec = rhs.mSlabVec;
+  memcpy(mSlabLists, rhs.mSlabLists, sizeof(mSlabLists));
+  mFreeSlabs = rhs.mFreeSlabs;
+  mLentSlabs = rhs.mLentSlabs;
+  mPurgedCount = rhs.mPurgedCount;
+  mLastPurge = rhs.mLastPurge;
+  mPurgeDue = rhs.mPurgeDue;
+  mBinHits = rhs.mBinHits;
+  mHeapHits = rhs.mHeapHits;
+  mNewPages = rhs.mNewPages;
+
+  return *this;
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Frees every block on the remote free list, the whole list is taken at once
+  so pushing threads never race the owner for a single block, the lock must
+  already be held
+******************************************************************************/
+void MemoryManager::DrainRemoteFrees(void)
+{
+  // if no blocks were freed remotely
+  if (mRemoteFrees.load(std::memory_order_relaxed) == NULL)
+  {
+    return;
+  }
+
+  void* block = mRemoteFrees.exchange(NULL, std::memory_order_acquire);
+
+  // while there are blocks left in the list
+  while (block)
+  {
+    void* next = *(void**)(block); // read the link before freeing overwrites it
+
+    Destroy(block);
+    block = next;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether a pointer is inside a given page of this arena
+
+\param ptr
+  the pointer to check
+
+\param pageIndex
+  the index of the page in mPageVec
+
+\return
+  true if the page holds the pointer, else false
+******************************************************************************/
+bool MemoryManager::IsInPage(const void* ptr, unsigned int pageIndex) const
+{
+  if (pageIndex < mPageVec.size())
+  {
+    const void* pagePtr = mPageVec[pageIndex].Ptr();
+
+    return ((ptr >= pagePtr) && ((uintptr_t)(ptr) < ((uintptr_t)(pagePtr)+mPageVec[pageIndex].Size())));
   }
 
   return false;
 }
 
-unsigned int MemoryManager::PageIndex(void* ptr) const
+/*!****************************************************************************
+\brief
+  Finds the page of this arena that holds a pointer using the page map
+
+\param ptr
+  the pointer to look up
+
+\return
+  the index of the page in mPageVec, mPageVec.size() if the arena does not
+  own the pointer
+******************************************************************************/
+unsigned int MemoryManager::PageIndex(const void* ptr) const
+{
+  PageMapEntry entry = pageMap.Find(ptr);
+
+  // if the pointer is not in one of this arena's pages of blocks
+  if (entry.page == 0 || entry.arena != index || entry.slab)
+  {
+    return (unsigned int)(mPageVec.size());
+  }
+
+  return entry.page - 1;
+}
+
+/*!****************************************************************************
+\brief
+  Hands out an object of a slab size class, a new slab page is made when
+  every slab of the class is full
+
+\param classIndex
+  the size class of the object, below SLAB_CLASS_COUNT
+
+\return
+  a pointer to the object
+******************************************************************************/
+void* MemoryManager::AllocateSlab(size_t classIndex)
+{
+  unsigned int slabIndex = mSlabLists[classIndex];
+  MemorySlab& slab = slabIndex ? mSlabVec[slabIndex - 1] : AllocateSlabPage(classIndex);
+  void* object = slab.Allocate();
+
+  // if that was the last free object in the slab
+  if (slab.Full())
+  {
+    UnlinkSlab(mSlabLists[classIndex], mSlabLists[classIndex]); // only the head of the list is ever used, so it is the one to unlink
+  }
+
+  return object;
+}
+
+/*!****************************************************************************
+\brief
+  Gives an object back to its slab and moves the slab to the list it now
+  belongs on
+
+\param ptr
+  the object to destroy
+
+\param entry
+  the page map entry of the object
+******************************************************************************/
+void MemoryManager::DestroySlab(void* ptr, const PageMapEntry& entry)
+{
+  MemorySlab& slab = mSlabVec[entry.page - 1];
+  bool wasFull = slab.Full();
+
+  slab.Destroy(ptr);
+  RelistSlab(entry, wasFull);
+}
+
+/*!****************************************************************************
+\brief
+  Takes a number of objects of one size class, filling each slab in turn
+  with contiguous runs before moving on to the next
+
+\param classIndex
+  the size class of the objects
+
+\param count
+  the number of objects to take
+
+\param objects
+  filled with the objects
+******************************************************************************/
+void MemoryManager::AllocateSlabRun(size_t classIndex, size_t count, void** objects)
+{
+  // while there are objects left to take
+  while (count)
+  {
+    unsigned int slabIndex = mSlabLists[classIndex];
+    MemorySlab& slab = slabIndex ? mSlabVec[slabIndex - 1] : AllocateSlabPage(classIndex);
+    size_t taken = slab.AllocateRun(objects, count);
+
+    objects += taken;
+    count -= taken;
+
+    // if that was the last free object in the slab
+    if (slab.Full())
+    {
+      UnlinkSlab(mSlabLists[classIndex], mSlabLists[classIndex]);
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Gives a chained list of objects back to the slab that holds them
+
+\param first
+  the first object, each object links to the next through its first bytes
+
+\param last
+  the last object
+
+\param count
+  the number of objects in the list
+
+\param entry
+  the page map entry of the slab
+******************************************************************************/
+void MemoryManager::DestroySlabList(void* first, void* last, size_t count, const PageMapEntry& entry)
+{
+  MemorySlab& slab = mSlabVec[entry.page - 1];
+  bool wasFull = slab.Full();
+
+  slab.DestroyList(first, last, count);
+  RelistSlab(entry, wasFull);
+}
+
+/*!****************************************************************************
+\brief
+  Moves a slab that objects were just given back to onto the list it now
+  belongs on. A slab that was full goes back on the list of its size class,
+  a slab that is empty leaves it for the list of empty slabs so any class or
+  a page of blocks can take its memory
+
+\param entry
+  the page map entry of the slab
+
+\param wasFull
+  true if the slab was full before the objects came back
+******************************************************************************/
+void MemoryManager::RelistSlab(const PageMapEntry& entry, bool wasFull)
+{
+  MemorySlab& slab = mSlabVec[entry.page - 1];
+
+  // if that was the last object in use
+  if (slab.Empty())
+  {
+    slab.idleSince = MarkIdle();
+    slab.purged = false;
+
+    // if the slab was on the list of its class
+    if (!wasFull)
+    {
+      UnlinkSlab(mSlabLists[entry.slab - 1], entry.page);
+    }
+
+    PushSlab(mFreeSlabs, entry.page);
+  }
+  // if the slab was off the list
+  else if (wasFull)
+  {
+    PushSlab(mSlabLists[entry.slab - 1], entry.page);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Gets a slab for a size class and puts it at the head of the class's list.
+  An empty slab of any class is used first, then a wholly free page of blocks
+  made from a slab, and only then a new page. If the page is not allocated,
+  throws a bad_alloc exception
+
+\param classIndex
+  the size class of the slab
+
+\return
+  the slab
+******************************************************************************/
+MemorySlab& MemoryManager::AllocateSlabPage(size_t classIndex)
+{
+  size_t objectSize = MemoryBins::ClassSize(classIndex);
+  unsigned int slabIndex = mFreeSlabs;
+  bool mapped = true; // false once the granules say the memory is a page of blocks
+
+  // if there is an empty slab
+  if (slabIndex)
+  {
+    UnlinkSlab(mFreeSlabs, slabIndex);
+  }
+  else
+  {
+    slabIndex = ReclaimSlab();
+    mapped = false;
+  }
+
+  // if memory of an old slab can be used again
+  if (slabIndex)
+  {
+    MemorySlab& slab = mSlabVec[slabIndex - 1];
+    void* page = const_cast<void*>(slab.Ptr());
+    unsigned int lentPage = slab.page;
+
+    // if the granules do not say the slab is of this class
+    if (!mapped || slab.ObjectSize() != objectSize)
+    {
+      pageMap.Insert(page, SLAB_SIZE, index, slabIndex - 1, (unsigned int)(classIndex + 1));
+    }
+
+    slab = MemorySlab(page, SLAB_SIZE, objectSize);
+    slab.page = lentPage;
+    PushSlab(mSlabLists[classIndex], slabIndex);
+
+    return slab;
+  }
+
+  void* page = mSource.Allocate(SLAB_SIZE);
+
+  // if the page could not be allocated
+  if (page == NULL)
+  {
+    throw std::bad_alloc();
+  }
+
+  mSlabVec.push_back(MemorySlab(page, SLAB_SIZE, objectSize));
+
+  slabIndex = (unsigned int)(mSlabVec.size());
+  pageMap.Insert(page, SLAB_SIZE, index, slabIndex - 1, (unsigned int)(classIndex + 1));
+  PushSlab(mSlabLists[classIndex], slabIndex);
+
+  return mSlabVec.back();
+}
+
+/*!****************************************************************************
+\brief
+  Takes back the memory of a slab that was lent to the pages of blocks once
+  the page made from it is wholly free again. Only the first few lent slabs
+  are looked at, so a slab page is never slower to get than a scan of a few
+  headers
+
+\return
+  one more than the index of the slab taken back, 0 if no page was free
+******************************************************************************/
+unsigned int MemoryManager::ReclaimSlab(void)
 {
-  ptr;
+  unsigned int slabIndex = mLentSlabs;
+
+  // for the first few lent slabs
+  for (size_t i = 0; slabIndex && i < SLAB_RECLAIM_SCAN; ++i)
+  {
+    MemorySlab& slab = mSlabVec[slabIndex - 1];
+    MemoryPage& page = mPageVec[slab.page - 1];
+    MemoryAllocated* memoryAlloced = (MemoryAllocated*)(const_cast<void*>(page.Ptr()));
+
+    // if the system has the page back, it is already out of the bins
+    if (page.IsPurged())
+    {
+      page.SetPurged(false);
+      --mPurgedCount;
+    }
+    // if the page is wholly free, the heap's header is never marked free
+    else if (memoryAlloced->IsFree() && memoryAlloced->Size() == page.Size())
+    {
+      mFreeBins.Remove(memoryAlloced->Memory(), MemoryBins::FloorIndex(page.Size()));
+    }
+    else
+    {
+      slabIndex = slab.next;
+      continue;
+    }
+
+    page.SetLent(true);
+    slab.lent = false;
+    UnlinkSlab(mLentSlabs, slabIndex);
+
+    return slabIndex;
+  }
+
   return 0;
 }
 
 /*!****************************************************************************
 \brief
-  Allocates memory for a new page and adds the page to the pageVec, if page
-  is not allocated, throws a bad_alloc exception and aborts the program
+  Puts a slab at the head of a list of slabs
+
+\param list
+  the head of the list, one more than the index of its first slab
+
+\param slabIndex
+  one more than the index of the slab, it must be on no list
+******************************************************************************/
+void MemoryManager::PushSlab(unsigned int& list, unsigned int slabIndex)
+{
+  MemorySlab& slab = mSlabVec[slabIndex - 1];
+
+  slab.prev = 0;
+  slab.next = list;
+
+  // if the list had a slab
+  if (list)
+  {
+    mSlabVec[list - 1].prev = slabIndex;
+  }
+
+  list = slabIndex;
+}
+
+/*!****************************************************************************
+\brief
+  Takes a slab off the list it is on
+
+\param list
+  the head of the list, one more than the index of its first slab
+
+\param slabIndex
+  one more than the index of the slab, it must be on the list
+******************************************************************************/
+void MemoryManager::UnlinkSlab(unsigned int& list, unsigned int slabIndex)
+{
+  MemorySlab& slab = mSlabVec[slabIndex - 1];
+
+  // if a slab is before this one
+  if (slab.prev)
+  {
+    mSlabVec[slab.prev - 1].next = slab.next;
+  }
+  else
+  {
+    list = slab.next;
+  }
+
+  // if a slab is after this one
+  if (slab.next)
+  {
+    mSlabVec[slab.next - 1].prev = slab.prev;
+  }
+
+  slab.prev = 0;
+  slab.next = 0;
+}
+
+/*!****************************************************************************
+\brief
+  Allocates memory for a new page, adds the page to the pageVec and marks its
+  granules in the page map. The page is rounded up to whole granules, so it
+  can be a little bigger than asked for. A purged page that is big enough is
+  used again before a new one is mapped, and a page the size of a slab is
+  made from an empty slab when there is one. If page is not allocated, throws a
+  bad_alloc exception and aborts the program
 
-\param pageSize
-  the size of the page to allocate in bytes
+\param minSize
+  the smallest number of user usable bytes the page must have
 
 \return
-  a pointer to the user usable memory
+  a block covering the user usable memory of the page
 ******************************************************************************/
-void* MemoryManager::AllocatePage(size_t pageSize)
+MemoryBlock MemoryManager::AllocatePage(size_t minSize)
 {
-  static unsigned int pageIndex = 0;
+  size_t totalSize = (minSize + 2 * sizeof(MemoryAllocated) + PAGE_ALIGNMENT - 1) & ~(PAGE_ALIGNMENT - 1); // with a header and a fence
+  size_t usableSize = totalSize - 2 * sizeof(MemoryAllocated);
+
+  // for all pages while some are purged
+  for (size_t i = 0; i < mPageVec.size() && mPurgedCount; ++i)
+  {
+    MemoryPage& purged = mPageVec[i];
+
+    // if the page is purged and big enough
+    if (purged.IsPurged() && purged.Size() >= usableSize)
+    {
+      MemoryAllocated* memoryAlloced = (MemoryAllocated*)(const_cast<void*>(purged.Ptr()));
+      *memoryAlloced = MemoryAllocated(purged.Size());  // the system zeroed the old header and fence
+      *memoryAlloced->Next() = MemoryAllocated(0);
+
+      purged.SetPurged(false);
+      --mPurgedCount;
+
+      return MemoryBlock(memoryAlloced->Memory(), purged.Size());
+    }
+  }
+
+  // if the page is the size of a slab and an empty slab can lend its memory
+  if (totalSize == SLAB_SIZE && mFreeSlabs)
+  {
+    unsigned int slabIndex = mFreeSlabs;
+    MemorySlab& slab = mSlabVec[slabIndex - 1];
+
+    UnlinkSlab(mFreeSlabs, slabIndex);
+    PushSlab(mLentSlabs, slabIndex);
+    slab.lent = true;
 
-  void* page = malloc(pageSize + sizeof(MemoryAllocated)); // allocate a page of page_size
+    // if the slab's memory has never been a page of blocks
+    if (slab.page == 0)
+    {
+      mPageVec.push_back(MemoryPage(const_cast<void*>(slab.Ptr()), usableSize));
+      slab.page = (unsigned int)(mPageVec.size());
+    }
+
+    MemoryPage& lent = mPageVec[slab.page - 1];
+    lent.SetLent(false);
+    pageMap.Insert(lent.Ptr(), totalSize, index, slab.page - 1, 0);
+
+    MemoryAllocated* memoryAlloced = (MemoryAllocated*)(const_cast<void*>(lent.Ptr()));
+    *memoryAlloced = MemoryAllocated(usableSize);
+    *memoryAlloced->Next() = MemoryAllocated(0);
+
+    return MemoryBlock(memoryAlloced->Memory(), usableSize);
+  }
+
+  void* page = mSource.Allocate(totalSize);
 
     // if page was allocated
   if (page)
   {
-    mPageVec.push_back(MemoryPage(page, pageSize)); // add page to back of mPages
+    mPageVec.push_back(MemoryPage(page, usableSize)); // add page to back of mPages
+    pageMap.Insert(page, totalSize, index, (unsigned int)(mPageVec.size() - 1), 0);
+
+    MemoryAllocated* memoryAlloced = (MemoryAllocated*)page;
+    *memoryAlloced = MemoryAllocated(usableSize);
+    *memoryAlloced->Next() = MemoryAllocated(0);  // fence, an empty block that is never free so merging stops at the page end
 
-    return (void*)((uintptr_t)(page)+sizeof(MemoryAllocated));  // move to user usable memory
+    return MemoryBlock(memoryAlloced->Memory(), usableSize); // move to user usable memory
   }
 
   throw std::bad_alloc(); // could not allocate memory
 }
 
+/*!****************************************************************************
+\brief
+  Gets a new heap when no free block or the old heap can hold a block. A
+  block bigger than a page gets a page of its own, sized to the block's whole
+  size class so that once it is freed the page lands in a bin any block of
+  that class can be taken from. Otherwise the arena grows by a share of the
+  pages it already holds, one becoming the heap and the rest going to the
+  free bins
+
+\param memSize
+  the number of bytes the heap has to hold
+
+\return
+  a block covering the user usable memory of the new heap
+******************************************************************************/
+MemoryBlock MemoryManager::GrowHeap(size_t memSize)
+{
+  size_t size = pageSize.load(std::memory_order_relaxed);
+
+  // if the block is larger than a page
+  if (memSize > size)
+  {
+    size_t classIndex = MemoryBins::ClassIndex(memSize);
+
+    return AllocatePage((classIndex < BIN_COUNT) ? MemoryBins::ClassSize(classIndex) : memSize); // allocate a page that fits memSize
+  }
+
+  MemoryBlock heap = AllocatePage(size);
+  size_t count = mPageVec.size() * pageGrowth.load(std::memory_order_relaxed) / 100;
+  size_t countMax = GROWTH_MAX / (size + 2 * sizeof(MemoryAllocated));
+
+  // for all the extra pages the arena grows by
+  for (size_t i = 1; i < count && i < countMax; ++i)
+  {
+    MemoryBlock temp = AllocatePage(size);
+
+    AddBlockToFree(temp);
+  }
+
+  return heap;
+}
 
 /*!****************************************************************************
 \brief
@@ -475,21 +3955,24 @@ void* MemoryManager::AllocateMemoryFromHeap(size_t size)
 {
   size_t heapSize = mHeap.Size();                     // the current size of the heap
 
-    // if heap is perfect size or heap can be split after allocation
-  if ((heapSize == size) || (heapSize > size + sizeof(MemoryAllocated)))
+    // if heap is big enough
+  if (heapSize >= size && heapSize > 0)
   {
     void* memory = mHeap.MemoryLocation();                                                            // get the location of the heap memory
     MemoryAllocated* memoryAlloced = (MemoryAllocated*)((uintptr_t)memory - sizeof(MemoryAllocated)); // move memory to alloced info
+
+      // if what is left of the heap would be too small to free later
+    if (heapSize - size < sizeof(MemoryAllocated) + MIN_BLOCK_SIZE)
+    {
+      size = heapSize;  // hand over the whole heap
+    }
+
     *memoryAlloced = MemoryAllocated(size);                                                           // insert alloced info in front of memory
 
-      // if we need a new heap after this allocation
+      // if the heap was used up by this allocation
     if (mHeap.Size() - size == 0)
     {
-      // if we did not get a heap from the free map
-      if (!GetHeapFromFreeMap())
-      {
-        mHeap = MemoryBlock(AllocatePage(), PAGE_SIZE); // allocate a new page and set the new heap
-      }
+      mHeap = MemoryBlock();  // the next allocation will find a new heap
     }
     // if heap is being split
     else
@@ -512,22 +3995,167 @@ void* MemoryManager::AllocateMemoryFromHeap(size_t size)
 ******************************************************************************/
 void MemoryManager::AddPageToFree(void* page)
 {
-  page = (void*)((uintptr_t)(page)+sizeof(MemoryAllocated));  // move page pointer to the right
-  unsigned int size = PAGE_SIZE - sizeof(MemoryAllocated);      // size of usable memory
+  MemoryBlock temp(page, pageSize.load(std::memory_order_relaxed)); // create a page block
 
-  MemoryBlock temp(page, size);                                       // create a page block
-  mFreeSize.insert(std::pair<size_t, MemoryBlock>(size, temp)); // add page to size table
-  mFreeLoc.insert(std::pair<void*, MemoryBlock>(page, temp));         // add page to loc table
+  AddBlockToFree(temp);
 }
 
 /*!****************************************************************************
 \brief
-  Adds a given MemoryBlock to the Free list
+  Adds a given MemoryBlock to the free bins, blocks too small to hold the free
+  list links are dropped
 ******************************************************************************/
 void MemoryManager::AddBlockToFree(MemoryBlock& block)
 {
-  mFreeSize.insert(std::pair<size_t, MemoryBlock>(block.Size(), block));
-  mFreeLoc.insert(std::pair<void*, MemoryBlock>(block.MemoryLocation(), block));
+  // if the block can hold the free list links
+  if (block.Size() >= MIN_BLOCK_SIZE)
+  {
+    FreeBlock(MemoryAllocated::FromMemory(block.MemoryLocation()));
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Frees a block using its boundary tags, the block is merged with a free block
+  or the heap on either side of it before it goes into the bins. The heap is
+  never marked free, it is found by its location instead
+
+\param memoryAlloced
+  the header of the block being freed
+******************************************************************************/
+void MemoryManager::FreeBlock(MemoryAllocated* memoryAlloced)
+{
+  size_t size = memoryAlloced->Size();
+  MemoryAllocated* next = memoryAlloced->Next();
+  bool nextIsHeap = (next->Memory() == mHeap.MemoryLocation());
+
+  // if the block after this one is free
+  if (next->IsFree())
+  {
+    mFreeBins.Remove(next->Memory(), MemoryBins::FloorIndex(next->Size()));
+    size += sizeof(MemoryAllocated) + next->Size();
+  }
+
+  // if the block before this one is free
+  if (memoryAlloced->IsPrevFree())
+  {
+    MemoryAllocated* prev = memoryAlloced->Prev();
+
+    mFreeBins.Remove(prev->Memory(), MemoryBins::FloorIndex(prev->Size()));
+    size += sizeof(MemoryAllocated) + prev->Size();
+    memoryAlloced = prev;
+  }
+
+  // if the heap starts right after this block
+  if (nextIsHeap)
+  {
+    MoveBlock(mHeap, size + sizeof(MemoryAllocated), false);  // grow the heap left over the block
+    return;
+  }
+
+  // if the heap ends right before this block
+  if ((uintptr_t)(mHeap.MemoryLocation()) + mHeap.Size() == (uintptr_t)(memoryAlloced))
+  {
+    mHeap = MemoryBlock(mHeap.MemoryLocation(), mHeap.Size() + sizeof(MemoryAllocated) + size);  // grow the heap right over the block
+    memoryAlloced = MemoryAllocated::FromMemory(mHeap.MemoryLocation());
+    memoryAlloced->Next()->SetPrevFree(false);
+    return;
+  }
+
+  memoryAlloced->SetSize(size);
+  memoryAlloced->SetFree(true);
+  memoryAlloced->Next()->SetPrevFree(true);
+
+  mFreeBins.Push(memoryAlloced->Memory(), size);
+
+  // if the block ends at a page's fence, so it could cover the whole page
+  if (memoryAlloced->Next()->Size() == 0)
+  {
+    MarkIdlePage(memoryAlloced);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Records the time a free block was made if it covers its whole page, that is
+  when the page starts to decay
+
+\param memoryAlloced
+  the header of the free block
+******************************************************************************/
+void MemoryManager::MarkIdlePage(MemoryAllocated* memoryAlloced)
+{
+  MemoryPage& page = mPageVec[pageMap.Find(memoryAlloced).page - 1];
+
+  // if the block is the whole page
+  if (page.Ptr() == memoryAlloced && page.Size() == memoryAlloced->Size())
+  {
+    page.SetIdleSince(MarkIdle());
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Gets the time a page or slab that just became wholly free starts to decay,
+  and lets the next free run a decay pass once a quarter of the decay time
+  has gone by since the last one
+
+\return
+  the current time in milliseconds
+******************************************************************************/
+uint64_t MemoryManager::MarkIdle(void)
+{
+  mPurgeDue = true;
+
+  return CurrentTime();
+}
+
+/*!****************************************************************************
+\brief
+  Marks a block taken out of the bins as in use
+
+\param block
+  the user memory of the block
+
+\return
+  the user memory of the block
+******************************************************************************/
+void* MemoryManager::UseBlock(void* block)
+{
+  MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(block);
+
+  memoryAlloced->SetFree(false);
+  memoryAlloced->Next()->SetPrevFree(false);
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Cuts an in use block down to the given size, the rest of the block is freed
+  if it is big enough to be a block of its own
+
+\param block
+  the user memory of the block
+
+\param size
+  the number of bytes the block should keep
+******************************************************************************/
+void MemoryManager::SplitBlock(void* block, size_t size)
+{
+  MemoryAllocated* memoryAlloced = MemoryAllocated::FromMemory(block);
+  size_t blockSize = memoryAlloced->Size();
+
+  // if the rest of the block is big enough to be freed
+  if (blockSize - size >= sizeof(MemoryAllocated) + MIN_BLOCK_SIZE)
+  {
+    memoryAlloced->SetSize(size);
+
+    MemoryAllocated* rest = memoryAlloced->Next();
+    *rest = MemoryAllocated(blockSize - size - sizeof(MemoryAllocated));
+
+    FreeBlock(rest);
+  }
 }
 
 /*!****************************************************************************
@@ -544,40 +4172,46 @@ void MemoryManager::AddBlockToFree(MemoryBlock& block)
 ******************************************************************************/
 void MemoryManager::MoveBlock(MemoryBlock& block, size_t amount, bool right)
 {
-  int size = (int)amount;
-
-  // if we are moving heap left
-  if (!right)
+  // if we are moving heap right
+  if (right)
   {
-    size = -size; // flip amount
+    block = MemoryBlock((void*)((uintptr_t)(block.MemoryLocation()) + amount), block.Size() - amount);
+  }
+  else
+  {
+    block = MemoryBlock((void*)((uintptr_t)(block.MemoryLocation()) - amount), block.Size() + amount);
   }
-
-  block = MemoryBlock((void*)((uintptr_t)(block.MemoryLocation()) + size), block.Size() - amount);
 }
 
 /*!****************************************************************************
 \brief
-  Gets the largest possible block from the free Map
+  Gets a block from the largest non empty bin and makes it the heap
 
-\param amount
-  the amount of bytes to move the heap
+\param minSize
+  the smallest block that is worth using as the heap
 
-\param right
-  a bool indicating whether to move the heap right or left in memory, if true
-  moves right, else moves left
+\return
+  true if the heap was replaced, else false
 ******************************************************************************/
-bool MemoryManager::GetHeapFromFreeMap(void)
+bool MemoryManager::GetHeapFromFreeMap(size_t minSize)
 {
-  // if free map has blocks
-  if (mFreeSize.size() > 0)
+  void* block = mFreeBins.PopLargest();
+
+  // if the bins had a block
+  if (block)
   {
-    MANAGER_SIZE_TABLE::iterator it = mFreeSize.find(PAGE_SIZE);  // get the end of the table
+    size_t size = MemoryAllocated::FromMemory(block)->Size();
 
-    mHeap = it->second;                           // set heap to the found block
-    mFreeLoc.erase(it->second.MemoryLocation());  // remove found block from location set
-    mFreeSize.erase(it);                          // remove the found block from the multimap
+    // if the block is big enough to be the heap
+    if (size >= minSize)
+    {
+      UseBlock(block);
+      mHeap = MemoryBlock(block, size);
 
-    return true;
+      return true;
+    }
+
+    mFreeBins.Push(block, size);  // put the block back
   }
 
   return false;
@@ -17,14 +17,53 @@
 // Include Files
 //-----------------------------------------------------------------------------
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <new>
+
 //-----------------------------------------------------------------------------
 // Forward References
 //-----------------------------------------------------------------------------
 
+struct MemoryConfig;
+struct MemoryStats;
+
 //-----------------------------------------------------------------------------
 // Public Consts
 //-----------------------------------------------------------------------------
 
+//! How the chunks that pages are carved from are backed by the system
+enum MemoryHugePages
+{
+  MEMORY_HUGE_PAGES_OFF,      //!< normal system pages
+  MEMORY_HUGE_PAGES_ADVISE,   //!< ask for transparent huge pages with madvise
+  MEMORY_HUGE_PAGES_EXPLICIT  //!< take huge pages from the reserved pool, falls back to advise when it is empty
+};
+
+const size_t MEMORY_DECAY_NEVER = SIZE_MAX; //!< a decay time that keeps free pages resident until Trim is called
+
+const size_t MEMORY_TRACE_SIZE = 1024 * 1024 * 1024; //!< the most bytes a trace file grows to unless MEMORY_TRACE_SIZE says otherwise
+
+const size_t MEMORY_PROFILE_RATE = 512 * 1024;  //!< the average bytes allocated between heap profile samples unless MEMORY_PROFILE_RATE says otherwise
+
+//! How MemoryManagerProfileDump writes the heap profile
+enum MemoryProfileFormat
+{
+  MEMORY_PROFILE_PPROF,       //!< the text heap profile pprof reads, live and cumulative samples of every call stack
+  MEMORY_PROFILE_FOLDED_LIVE, //!< one line of frames and estimated live bytes per call stack, for flame graphs
+  MEMORY_PROFILE_FOLDED_TOTAL //!< the same with the estimated bytes allocated since the profile started
+};
+
+const size_t MEMORY_STATS_BIN_COUNT = 64;   //!< the number of free bins whose bytes are reported, one per size class
+
+//! How DumpStats writes the statistics
+enum MemoryStatsFormat
+{
+  MEMORY_STATS_TEXT,  //!< one name and value per line
+  MEMORY_STATS_JSON   //!< a single JSON object
+};
+
 //-----------------------------------------------------------------------------
 // Public Variables
 //-----------------------------------------------------------------------------
@@ -37,18 +76,118 @@ void* operator new(size_t size);
 
 void* operator new[](size_t size);
 
-void operator delete(void* ptr);
+void operator delete(void* ptr) noexcept;
+
+void operator delete[](void* ptr) noexcept;
+
+void operator delete(void* ptr, size_t size) noexcept;
+
+void operator delete[](void* ptr, size_t size) noexcept;
+
+void* operator new(size_t size, std::align_val_t alignment);
+
+void* operator new[](size_t size, std::align_val_t alignment);
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept;
 
-void operator delete[](void* ptr);
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept;
+
+void operator delete(void* ptr, size_t size, std::align_val_t alignment) noexcept;
+
+void operator delete[](void* ptr, size_t size, std::align_val_t alignment) noexcept;
 
 void MemoryManagerInit(void);
+void MemoryManagerInit(const MemoryConfig& config);
+void MemoryManagerGetConfig(MemoryConfig& config);
 
 void* Alloc(size_t size);
 void Delete(void* ptr);
+void Delete(void* ptr, size_t size);
+void* Realloc(void* ptr, size_t size);
+void* AllocAligned(size_t size, size_t alignment);
+int PosixMemalign(void** memptr, size_t alignment, size_t size);
+void* AlignedAlloc(size_t alignment, size_t size);
+
+void AllocBatch(size_t size, size_t count, void** blocks);
+void DeleteBatch(void** blocks, size_t count);
 
 void MemoryManagerShutdown(void);
 
+bool MemoryManagerOwns(const void* ptr);
+bool MemoryManagerReady(void);
+bool TryDelete(void* ptr);
+size_t UsableSize(const void* ptr);
+
+void MemoryManagerLock(void);
+void MemoryManagerUnlock(void);
+
+void* MemoryManagerMapPages(size_t size);
+void MemoryManagerUnmapPages(void* ptr, size_t size);
+
+void MemoryManagerHugePages(MemoryHugePages mode);
+void MemoryManagerLargeThreshold(size_t size);
+
+void MemoryManagerDecay(size_t milliseconds);
+void MemoryManagerBackgroundPurge(bool enable);
+size_t Trim(size_t targetBytes);
+
+void GetStats(MemoryStats& stats);
+void DumpStats(FILE* file, MemoryStatsFormat format);
+
+bool MemoryManagerTraceStart(const char* path, size_t size);
+void MemoryManagerTraceStop(void);
+
+bool MemoryManagerProfileStart(size_t rate);
+void MemoryManagerProfileStop(void);
+bool MemoryManagerProfileDump(FILE* file, MemoryProfileFormat format);
+
+unsigned int MemoryManagerArenaCount(void);
+size_t MemoryManagerArenaContention(unsigned int arena);
+
+void* MemoryManagerHeapAlloc(unsigned int heap, size_t size, size_t alignment);
+void MemoryManagerHeapDelete(void* ptr);
+
 //-----------------------------------------------------------------------------
 // Classes
 //-----------------------------------------------------------------------------
 
+//! The settings the manager grows its arenas with. The defaults can be
+//! changed before the program starts with the environment variables named
+//! below, sizes there take an optional K, M or G suffix
+struct MemoryConfig
+{
+  size_t pageSize;        //!< the bytes in a page with its header and fence, rounded up to whole granules, MEMORY_PAGE_SIZE
+  size_t initialPages;    //!< the pages MemoryManagerInit gives the first arena, MEMORY_INITIAL_PAGES
+  size_t pageGrowth;      //!< the percent of the pages an arena holds that it adds at once when it runs out, 0 adds one page, MEMORY_PAGE_GROWTH
+  size_t largeThreshold;  //!< the smallest block that gets a system mapping of its own, MEMORY_LARGE_THRESHOLD
+  size_t decayTime;       //!< the milliseconds a whole free page stays resident before it is purged, MEMORY_DECAY_TIME
+};
+
+//! A snapshot of what the manager is doing. The call counters are kept by
+//! every thread for itself and the memory figures are measured from the
+//! arenas, both only when GetStats is called. Blocks waiting in a thread
+//! cache count as in use
+struct MemoryStats
+{
+  size_t allocations;     //!< blocks handed out by every thread
+  size_t frees;           //!< blocks given back by every thread
+  size_t cacheHits;       //!< allocations served from a thread cache without locking
+  size_t cacheRefills;    //!< batches a thread cache took from an arena when it was empty
+  size_t cacheFlushes;    //!< batches a thread cache gave back to an arena when it was full
+  size_t binHits;         //!< blocks an arena found in a free bin
+  size_t heapHits;        //!< blocks an arena split from its heap
+  size_t newPages;        //!< times an arena needed a new page because no bin or heap had room
+  size_t largeBlocks;     //!< blocks with a system mapping of their own
+  size_t largeBytes;      //!< the bytes mapped for those blocks
+  size_t pages;           //!< the pages every arena holds, purged ones included
+  size_t pageBytes;       //!< the bytes of pages that are not purged, headers and fences included
+  size_t slabs;           //!< the slab pages every arena holds, purged ones included
+  size_t slabBytes;       //!< the bytes of slab pages that are not purged
+  size_t purgedBytes;     //!< the bytes of pages and slabs given back to the system and kept for reuse
+  size_t bytesInUse;      //!< the bytes of pages, slabs and mappings not free, headers and blocks held in thread caches included
+  size_t freeBytes;       //!< the bytes free in bins, heaps and slabs that are not purged
+  size_t largestFree;     //!< the biggest block in any bin or heap
+  size_t binFreeBytes[MEMORY_STATS_BIN_COUNT]; //!< the bytes in each free bin of every arena
+  double fragmentation;   //!< how much of the free bytes in pages partly in use can not go to a single block, wholly free pages left out
+};
+
@@ -0,0 +1,206 @@
+/*!****************************************************************************
+\file     MemoryNodePool.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all MemoryNodePool class functions
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryNodePool.h"
+#include "MemoryManager.h"
+#include <new>
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryNodePool
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Makes an empty pool held by one allocator, no slab is mapped until the
+  first node is allocated
+******************************************************************************/
+MemoryNodePool::MemoryNodePool(void) :
+                               mNodeSize(0),
+                               mFree(NULL),
+                               mCursor(NULL),
+                               mEnd(NULL),
+                               mSlabs(NULL),
+                               mRefs(1)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Unmaps every slab, nodes still alive go with them
+******************************************************************************/
+MemoryNodePool::~MemoryNodePool(void)
+{
+  // while there are slabs left
+  while (mSlabs)
+  {
+    Slab* next = mSlabs->next;
+
+    MemoryManagerUnmapPages(mSlabs, NODE_POOL_SLAB_SIZE);
+    mSlabs = next;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Hands out a node, dead nodes are used first and then the untouched end of
+  the newest slab
+
+\param size
+  the size of the node, Holds(size) must be true
+
+\return
+  the node
+******************************************************************************/
+void* MemoryNodePool::Allocate(size_t size)
+{
+  // if this is the first node
+  if (mNodeSize == 0)
+  {
+    mNodeSize = (size + NODE_POOL_ALIGNMENT - 1) & ~(NODE_POOL_ALIGNMENT - 1);
+  }
+
+  void* node = mFree;
+
+  // if there is a dead node
+  if (node)
+  {
+    mFree = *(void**)(node);
+    return node;
+  }
+
+  // if the newest slab is used up
+  if (mCursor == mEnd)
+  {
+    AllocateSlab();
+  }
+
+  node = mCursor;
+  mCursor += mNodeSize;
+
+  return node;
+}
+
+/*!****************************************************************************
+\brief
+  Takes back a node from Allocate
+
+\param node
+  the node to take back
+******************************************************************************/
+void MemoryNodePool::Destroy(void* node)
+{
+  *(void**)(node) = mFree;
+  mFree = node;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether a single object of a size can come from the pool
+
+\param size
+  the size of the object
+
+\return
+  true if size is the node size or no node has been allocated yet and size
+  fits in a slab, else false
+******************************************************************************/
+bool MemoryNodePool::Holds(size_t size) const
+{
+  // if the node size is not chosen yet
+  if (mNodeSize == 0)
+  {
+    return size >= sizeof(void*) && size + NODE_POOL_ALIGNMENT <= NODE_POOL_SLAB_SIZE;
+  }
+
+  return (size + NODE_POOL_ALIGNMENT - 1) / NODE_POOL_ALIGNMENT == mNodeSize / NODE_POOL_ALIGNMENT;
+}
+
+/*!****************************************************************************
+\brief
+  Records another allocator sharing the pool
+******************************************************************************/
+void MemoryNodePool::AddRef(void)
+{
+  mRefs.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Records an allocator letting go of the pool, the last one destroys it
+******************************************************************************/
+void MemoryNodePool::Release(void)
+{
+  // if that was the last allocator
+  if (mRefs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    delete this;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Maps a new slab and makes it the one nodes are carved from, throws
+  bad_alloc if the system is out of memory
+******************************************************************************/
+void MemoryNodePool::AllocateSlab(void)
+{
+  Slab* slab = static_cast<Slab*>(MemoryManagerMapPages(NODE_POOL_SLAB_SIZE));
+
+  // if the system is out of memory
+  if (slab == NULL)
+  {
+    throw std::bad_alloc();
+  }
+
+  slab->next = mSlabs;
+  mSlabs = slab;
+
+  mCursor = reinterpret_cast<char*>(slab) + NODE_POOL_ALIGNMENT;
+  mEnd = mCursor + (NODE_POOL_SLAB_SIZE - NODE_POOL_ALIGNMENT) / mNodeSize * mNodeSize;
+}
+
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,86 @@
+/*!****************************************************************************
+\file     MemoryNodePool.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the MemoryNodePool class, a pool of equal sized nodes shared by
+  the copies of a MemoryAllocator that was asked for one
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <atomic>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t NODE_POOL_SLAB_SIZE = 64 * 1024; //!< the number of bytes mapped for each slab of a node pool
+const size_t NODE_POOL_ALIGNMENT = 16;        //!< the alignment of every node and of the first node in a slab
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! Hands out nodes of one size for a single container. The size is not known
+//! until the container allocates its first single object, a node once its
+//! allocator has been rebound, so the pool takes the size of that object and
+//! turns away every other size. Slabs are mapped from the page source and go
+//! back when the last allocator sharing the pool lets go of it. Like the
+//! container it serves, a pool is used by one thread at a time, only the
+//! count of allocators sharing it can change from any thread
+class MemoryNodePool
+{
+  public:
+
+    MemoryNodePool(void);
+    ~MemoryNodePool(void);
+
+    MemoryNodePool(const MemoryNodePool& rhs) = delete;
+    MemoryNodePool& operator=(const MemoryNodePool& rhs) = delete;
+
+    void* Allocate(size_t size);
+    void Destroy(void* node);
+    bool Holds(size_t size) const;
+
+    void AddRef(void);
+    void Release(void);
+
+  private:
+
+    //! The start of every slab, links the slabs so they can be unmapped
+    struct Slab
+    {
+      Slab* next; //!< the slab mapped before this one
+    };
+
+    size_t mNodeSize; //!< the size of every node, 0 until the first node is allocated
+    void* mFree;      //!< dead nodes, linked through their memory
+    char* mCursor;    //!< the first node in the newest slab that was never handed out
+    char* mEnd;       //!< the end of the last whole node in the newest slab
+    Slab* mSlabs;     //!< every slab, newest first
+    std::atomic<size_t> mRefs;  //!< the number of allocators sharing the pool
+
+    void AllocateSlab(void);
+};
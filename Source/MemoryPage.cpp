@@ -15,7 +15,6 @@
 //-----------------------------------------------------------------------------
 
 #include "MemoryPage.h"
-#include <stdlib.h>
 
 //-----------------------------------------------------------------------------
 // Private Consts
@@ -46,17 +45,23 @@
 
 MemoryPage::MemoryPage(void) : 
                        mPtr(nullptr),
-                       mSize(0)
+                       mSize(0),
+                       mIdleSince(0),
+                       mPurged(false),
+                       mLent(false)
 {
 }
 
 MemoryPage::MemoryPage(void* ptr, size_t size) :
                        mPtr(ptr),
-                       mSize(size)
+                       mSize(size),
+                       mIdleSince(0),
+                       mPurged(false),
+                       mLent(false)
 {
 }
 
-unsigned int MemoryPage::Size(void) const
+size_t MemoryPage::Size(void) const
 {
   return mSize;
 }
@@ -66,10 +71,58 @@ const void* MemoryPage::Ptr(void) const
   return mPtr;
 }
 
-void MemoryPage::Destroy(void)
+/*!****************************************************************************
+\brief
+  Gets when the whole page was last seen free
+
+\return
+  the time in milliseconds, 0 if the page is not idle
+******************************************************************************/
+uint64_t MemoryPage::IdleSince(void) const
+{
+  return mIdleSince;
+}
+
+void MemoryPage::SetIdleSince(uint64_t time)
+{
+  mIdleSince = time;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether the system has been told it can take the page back, a
+  purged page is in no bin and its header has to be written again before
+  it is used
+
+\return
+  true if the page is purged, else false
+******************************************************************************/
+bool MemoryPage::IsPurged(void) const
+{
+  return mPurged;
+}
+
+void MemoryPage::SetPurged(bool purged)
+{
+  mPurged = purged;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether the page's memory was taken back by the slab it was made
+  from, a lent page is in no bin and has no header until it is returned
+
+\return
+  true if the page is lent to a slab, else false
+******************************************************************************/
+bool MemoryPage::IsLent(void) const
+{
+  return mLent;
+}
+
+void MemoryPage::SetLent(bool lent)
 {
-  free(mPtr);
-  mPtr = NULL;
+  mLent = lent;
 }
 
 //-----------------------------------------------------------------------------
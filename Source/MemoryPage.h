@@ -18,6 +18,7 @@
 //-----------------------------------------------------------------------------
 
 #include <set>
+#include <stdint.h>
 #include "MemoryBlock.h"
 
 //-----------------------------------------------------------------------------
@@ -28,6 +29,8 @@
 // Public Consts
 //-----------------------------------------------------------------------------
 
+const size_t PAGE_ALIGNMENT = 4096; //!< pages start and end on this boundary so no other memory shares their granules
+
 //-----------------------------------------------------------------------------
 // Public Variables
 //-----------------------------------------------------------------------------
@@ -49,13 +52,23 @@ class MemoryPage
 
     ~MemoryPage() = default;
 
-    unsigned int Size(void) const;
+    size_t Size(void) const;
     const void* Ptr(void) const;
 
-    void Destroy(void);
+    uint64_t IdleSince(void) const;
+    void SetIdleSince(uint64_t time);
+
+    bool IsPurged(void) const;
+    void SetPurged(bool purged);
+
+    bool IsLent(void) const;
+    void SetLent(bool lent);
 
   private:
     
     void* mPtr;   // pointer to the page memory
     size_t mSize; // size of the page in bytes
+    uint64_t mIdleSince;  // the time in milliseconds the whole page was last seen free, 0 if it is not idle
+    bool mPurged;         // true while the system has been told it can take the page back
+    bool mLent;           // true while the page's memory is a slab, it then holds no blocks
 };
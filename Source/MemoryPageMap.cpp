@@ -0,0 +1,286 @@
+/*!****************************************************************************
+\file     MemoryPageMap.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all MemoryPageMap class functions. A granule
+  number is split into root, middle and leaf bits, the root and middle levels
+  hold pointers to the next level and the leaves hold the entries
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryPageMap.h"
+#include "MemoryManager.h"
+#include <new>
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+const size_t PAGE_MAP_MID_COUNT = size_t(1) << PAGE_MAP_MID_BITS;    //!< pointers in a middle node
+const size_t PAGE_MAP_LEAF_COUNT = size_t(1) << PAGE_MAP_LEAF_BITS;  //!< entries in a leaf
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Function Declerations
+//-----------------------------------------------------------------------------
+
+static void* AllocateNode(std::atomic<void*>& slot, size_t size);
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryPageMap
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Marks every granule of a page as belonging to it, the page has to start and
+  end on granule boundaries so no other memory shares its granules
+
+\param ptr
+  the start of the page
+
+\param size
+  the size of the page in bytes, a multiple of the granule size
+
+\param arena
+  the arena that owns the page
+
+\param page
+  the index of the page in the arena's page vector, or in its slab vector
+
+\param slab
+  one more than the size class of a slab page, 0 for a page of blocks with
+  headers
+******************************************************************************/
+void MemoryPageMap::Insert(const void* ptr, size_t size, unsigned int arena, unsigned int page, unsigned int slab)
+{
+  uintptr_t first = (uintptr_t)(ptr) >> PAGE_MAP_SHIFT;
+  uintptr_t last = ((uintptr_t)(ptr) + size - 1) >> PAGE_MAP_SHIFT;
+
+  // for all granules in the page
+  for (uintptr_t granule = first; granule <= last; ++granule)
+  {
+    PageMapEntry* entry = Leaf(granule) + (granule & (PAGE_MAP_LEAF_COUNT - 1));
+
+    entry->arena = (uint16_t)(arena);
+    entry->slab = (uint16_t)(slab);
+    entry->page = page + 1;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Marks every granule of a direct mapping as belonging to no arena, each entry
+  counts the granules back to the start of the mapping so the start can be
+  found from any pointer inside it
+
+\param ptr
+  the start of the mapping, on a granule boundary
+
+\param size
+  the size of the mapping in bytes, a multiple of the granule size
+******************************************************************************/
+void MemoryPageMap::InsertMapping(const void* ptr, size_t size)
+{
+  uintptr_t first = (uintptr_t)(ptr) >> PAGE_MAP_SHIFT;
+  uintptr_t last = ((uintptr_t)(ptr) + size - 1) >> PAGE_MAP_SHIFT;
+
+  // for all granules in the mapping
+  for (uintptr_t granule = first; granule <= last; ++granule)
+  {
+    PageMapEntry* entry = Leaf(granule) + (granule & (PAGE_MAP_LEAF_COUNT - 1));
+
+    entry->arena = PAGE_MAP_NO_ARENA;
+    entry->slab = 0;
+    entry->page = (uint32_t)(granule - first) + 1;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Clears every granule of a page before its memory goes back to the system
+
+\param ptr
+  the start of the page
+
+\param size
+  the size of the page in bytes
+******************************************************************************/
+void MemoryPageMap::Erase(const void* ptr, size_t size)
+{
+  uintptr_t first = (uintptr_t)(ptr) >> PAGE_MAP_SHIFT;
+  uintptr_t last = ((uintptr_t)(ptr) + size - 1) >> PAGE_MAP_SHIFT;
+
+  // for all granules in the page
+  for (uintptr_t granule = first; granule <= last; ++granule)
+  {
+    PageMapEntry* entry = Leaf(granule) + (granule & (PAGE_MAP_LEAF_COUNT - 1));
+
+    entry->arena = 0;
+    entry->slab = 0;
+    entry->page = 0;
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Looks up the page that holds a pointer, safe to call on any pointer from any
+  thread
+
+\param ptr
+  the pointer to look up
+
+\return
+  the entry for the pointer's granule, page is 0 if no page holds the pointer
+******************************************************************************/
+PageMapEntry MemoryPageMap::Find(const void* ptr) const
+{
+  uintptr_t granule = (uintptr_t)(ptr) >> PAGE_MAP_SHIFT;
+
+  // if the pointer is past the address bits the map covers
+  if (granule >> (PAGE_MAP_ROOT_BITS + PAGE_MAP_MID_BITS + PAGE_MAP_LEAF_BITS))
+  {
+    return PageMapEntry();
+  }
+
+  std::atomic<void*>* mid = (std::atomic<void*>*)mRoot[granule >> (PAGE_MAP_MID_BITS + PAGE_MAP_LEAF_BITS)].load(std::memory_order_acquire);
+
+  // if nothing was ever inserted under this root slot
+  if (mid == NULL)
+  {
+    return PageMapEntry();
+  }
+
+  PageMapEntry* leaf = (PageMapEntry*)mid[(granule >> PAGE_MAP_LEAF_BITS) & (PAGE_MAP_MID_COUNT - 1)].load(std::memory_order_acquire);
+
+  // if nothing was ever inserted under this middle slot
+  if (leaf == NULL)
+  {
+    return PageMapEntry();
+  }
+
+  return leaf[granule & (PAGE_MAP_LEAF_COUNT - 1)];
+}
+
+/*!****************************************************************************
+\brief
+  Finds the start of the direct mapping that holds a pointer
+
+\param ptr
+  a pointer inside a mapping added with InsertMapping
+
+\return
+  the start of the mapping
+******************************************************************************/
+void* MemoryPageMap::MappingStart(const void* ptr) const
+{
+  PageMapEntry entry = Find(ptr);
+  uintptr_t granule = ((uintptr_t)(ptr) >> PAGE_MAP_SHIFT) - (entry.page - 1);
+
+  return (void*)(granule << PAGE_MAP_SHIFT);
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Gets the leaf that holds a granule, creating the middle node and leaf if
+  they do not exist yet
+
+\param granule
+  the address shifted down by PAGE_MAP_SHIFT
+
+\return
+  the first entry of the leaf
+******************************************************************************/
+PageMapEntry* MemoryPageMap::Leaf(uintptr_t granule)
+{
+  std::atomic<void*>& midSlot = mRoot[granule >> (PAGE_MAP_MID_BITS + PAGE_MAP_LEAF_BITS)];
+  std::atomic<void*>* mid = (std::atomic<void*>*)AllocateNode(midSlot, PAGE_MAP_MID_COUNT * sizeof(std::atomic<void*>));
+
+  std::atomic<void*>& leafSlot = mid[(granule >> PAGE_MAP_LEAF_BITS) & (PAGE_MAP_MID_COUNT - 1)];
+
+  return (PageMapEntry*)AllocateNode(leafSlot, PAGE_MAP_LEAF_COUNT * sizeof(PageMapEntry));
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Gets the node in a slot, arenas insert pages without sharing a lock so a new
+  node is only kept by the first thread to fill the slot
+
+\param slot
+  the slot that points to the node
+
+\param size
+  the size of the node in bytes
+
+\return
+  the node in the slot
+******************************************************************************/
+static void* AllocateNode(std::atomic<void*>& slot, size_t size)
+{
+  void* node = slot.load(std::memory_order_acquire);
+
+  // if the slot is already filled
+  if (node)
+  {
+    return node;
+  }
+
+  // mapped straight from the system, malloc may be the manager itself and
+  // this runs under an arena's lock. Fresh pages are zeroed, so every slot
+  // and entry starts empty
+  void* newNode = MemoryManagerMapPages(size);
+
+  // if the node could not be allocated
+  if (newNode == NULL)
+  {
+    throw std::bad_alloc();
+  }
+
+  // if another thread filled the slot first
+  if (!slot.compare_exchange_strong(node, newNode, std::memory_order_acq_rel, std::memory_order_acquire))
+  {
+    MemoryManagerUnmapPages(newNode, size);
+  }
+  else
+  {
+    node = newNode;
+  }
+
+  return node;
+}
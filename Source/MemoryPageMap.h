@@ -0,0 +1,81 @@
+/*!****************************************************************************
+\file     MemoryPageMap.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the MemoryPageMap class, a radix tree from any address to the page
+  that holds it
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const unsigned int PAGE_MAP_SHIFT = 12;   //!< the map tracks address space in 4 KiB granules
+const unsigned int PAGE_MAP_ADDRESS_BITS = (sizeof(void*) == 8) ? 48 : 32; //!< the address bits a user pointer can use
+const unsigned int PAGE_MAP_LEAF_BITS = (PAGE_MAP_ADDRESS_BITS - PAGE_MAP_SHIFT) / 3;  //!< granule bits resolved by a leaf
+const unsigned int PAGE_MAP_MID_BITS = PAGE_MAP_LEAF_BITS;                            //!< granule bits resolved by a middle node
+const unsigned int PAGE_MAP_ROOT_BITS = PAGE_MAP_ADDRESS_BITS - PAGE_MAP_SHIFT - 2 * PAGE_MAP_LEAF_BITS; //!< granule bits resolved by the root
+
+const uint16_t PAGE_MAP_NO_ARENA = 0xFFFF;  //!< the arena of granules that hold a direct mapped block instead of a page
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! What the map knows about one granule of address space
+struct PageMapEntry
+{
+  uint16_t arena; //!< the arena that owns the page
+  uint16_t slab;  //!< one more than the size class of a slab page, 0 for a page of blocks with headers
+  uint32_t page;  //!< one more than the index of the page in its arena, or than the granule's offset into a direct mapping, 0 when nothing covers the granule
+};
+
+//! A three level radix tree keyed by address bits, any pointer is looked up in
+//! three loads without locking. Nodes are created on first use and never freed,
+//! so the map has to live in static storage
+class MemoryPageMap
+{
+  public:
+
+    constexpr MemoryPageMap(void) : mRoot() {}
+    ~MemoryPageMap(void) = default;
+
+    void Insert(const void* ptr, size_t size, unsigned int arena, unsigned int page, unsigned int slab);
+    void InsertMapping(const void* ptr, size_t size);
+    void Erase(const void* ptr, size_t size);
+    PageMapEntry Find(const void* ptr) const;
+    void* MappingStart(const void* ptr) const;
+
+  private:
+
+    std::atomic<void*> mRoot[size_t(1) << PAGE_MAP_ROOT_BITS]; //!< the middle nodes, NULL until a page is inserted under them
+
+    PageMapEntry* Leaf(uintptr_t granule);
+};
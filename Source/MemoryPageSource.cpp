@@ -0,0 +1,430 @@
+/*!****************************************************************************
+\file     MemoryPageSource.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all MemoryPageSource class functions. Chunks
+  come from mmap or VirtualAlloc aligned to CHUNK_SIZE so the kernel can back
+  each one with a single huge page, either from the reserved pool with
+  MAP_HUGETLB or as a transparent huge page with madvise
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryPageSource.h"
+#include "MemoryPage.h"
+#include <atomic>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Variables
+//-----------------------------------------------------------------------------
+
+static std::atomic<int> hugePages(MEMORY_HUGE_PAGES_OFF);  //!< how new chunks are backed
+
+//-----------------------------------------------------------------------------
+// Private Function Declerations
+//-----------------------------------------------------------------------------
+
+static void* MapSystem(size_t size, void** base, size_t* mappedSize);
+static void UnmapSystem(void* base, size_t size);
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryPageSource
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+MemoryPageSource::MemoryPageSource(void) :
+                                   mCursor(NULL),
+                                   mEnd(NULL),
+                                   mChunks(0)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Changes how chunks mapped from now on are backed, chunks that are already
+  mapped keep their pages
+
+\param mode
+  the kind of huge pages to ask for
+******************************************************************************/
+void MemoryPageSource::SetHugePages(MemoryHugePages mode)
+{
+  hugePages.store(mode, std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Maps memory for a single block that does not go through an arena, it has
+  no alignment beyond the system page and is not tracked by any source
+
+\param size
+  the number of bytes needed, a multiple of PAGE_ALIGNMENT
+
+\return
+  the mapped memory, NULL if the system is out of memory
+******************************************************************************/
+void* MemoryPageSource::MapDirect(size_t size)
+{
+#if defined(_WIN32)
+  return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  // if the memory could not be mapped
+  if (memory == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  #if defined(MADV_HUGEPAGE)
+  // if huge pages were asked for and the block covers at least one
+  if (hugePages.load(std::memory_order_relaxed) != MEMORY_HUGE_PAGES_OFF && size >= CHUNK_SIZE)
+  {
+    madvise(memory, size, MADV_HUGEPAGE);
+  }
+  #endif
+
+  return memory;
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Gives memory from MapDirect or RemapDirect back to the system
+
+\param ptr
+  the mapped memory
+
+\param size
+  the size it was mapped with
+******************************************************************************/
+void MemoryPageSource::UnmapDirect(void* ptr, size_t size)
+{
+#if defined(_WIN32)
+  size;
+  VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+  munmap(ptr, size);
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Resizes memory from MapDirect without copying it, the kernel grows the
+  mapping in place or moves its pages to a new address
+
+\param ptr
+  the mapped memory
+
+\param oldSize
+  the size it was mapped with
+
+\param newSize
+  the size it should have, a multiple of PAGE_ALIGNMENT
+
+\return
+  the resized memory, NULL if the system can not remap memory, the old
+  mapping is then untouched
+******************************************************************************/
+void* MemoryPageSource::RemapDirect(void* ptr, size_t oldSize, size_t newSize)
+{
+#if defined(__linux__)
+  void* memory = mremap(ptr, oldSize, newSize, MREMAP_MAYMOVE);
+
+  // if the mapping could not be resized
+  if (memory == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  return memory;
+#else
+  ptr;
+  oldSize;
+  newSize;
+  return NULL;
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Tells the system the contents of some pages are no longer needed, so it
+  can take back the physical memory behind them. The pages stay mapped and
+  read back as zeros or their old contents once they are touched again
+
+\param ptr
+  the first page, a multiple of PAGE_ALIGNMENT
+
+\param size
+  the number of bytes, a multiple of PAGE_ALIGNMENT
+
+\return
+  true if the system took the pages, false if it refused, as it does for part
+  of an explicit huge page
+******************************************************************************/
+bool MemoryPageSource::Purge(void* ptr, size_t size)
+{
+#if defined(_WIN32)
+  return VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE) != NULL;
+#else
+  return madvise(ptr, size, MADV_DONTNEED) == 0;
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Gets memory for a page, small pages are carved from the current chunk and
+  pages too big to share a chunk get a mapping of their own
+
+\param size
+  the size of the page in bytes, a multiple of PAGE_ALIGNMENT
+
+\return
+  the page memory aligned to PAGE_ALIGNMENT, NULL if the system is out of
+  memory
+******************************************************************************/
+void* MemoryPageSource::Allocate(size_t size)
+{
+  // if the page would use up most of a chunk
+  if (size > CHUNK_SIZE / 2)
+  {
+    return Map(size);
+  }
+
+  // if the current chunk does not have room left
+  if ((size_t)(mEnd - mCursor) < size)
+  {
+    mCursor = (char*)(Map(CHUNK_SIZE));  // the rest of the old chunk is never touched so it costs no memory
+    mEnd = mCursor ? mCursor + CHUNK_SIZE : NULL;
+
+    // if the system is out of memory
+    if (mCursor == NULL)
+    {
+      return NULL;
+    }
+  }
+
+  void* page = mCursor;
+  mCursor += size;
+
+  return page;
+}
+
+/*!****************************************************************************
+\brief
+  Gives every chunk back to the system, every page carved from them is gone
+******************************************************************************/
+void MemoryPageSource::Release(void)
+{
+  // for all mapped chunks
+  for (const Chunk& chunk : mChunks)
+  {
+    UnmapSystem(chunk.base, chunk.size);
+  }
+
+  mChunks.clear();
+  mCursor = NULL;
+  mEnd = NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Maps memory from the system and remembers it for Release
+
+\param size
+  the number of bytes needed, a multiple of PAGE_ALIGNMENT
+
+\return
+  the memory aligned to CHUNK_SIZE, NULL if the system is out of memory
+******************************************************************************/
+void* MemoryPageSource::Map(size_t size)
+{
+  Chunk chunk = {};
+  void* memory = MapSystem(size, &chunk.base, &chunk.size);
+
+  // if the memory was mapped
+  if (memory)
+  {
+    mChunks.push_back(chunk);
+  }
+
+  return memory;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Maps readable and writable memory aligned to CHUNK_SIZE, a huge page
+  mapping that fails falls back to normal pages
+
+\param size
+  the number of bytes needed
+
+\param base
+  set to the start of the whole mapping, pass it to UnmapSystem
+
+\param mappedSize
+  set to the number of bytes actually mapped, pass it to UnmapSystem
+
+\return
+  the mapped memory, NULL if the system is out of memory
+******************************************************************************/
+static void* MapSystem(size_t size, void** base, size_t* mappedSize)
+{
+  int mode = hugePages.load(std::memory_order_relaxed);
+  size_t hugeSize = (size + CHUNK_SIZE - 1) & ~(CHUNK_SIZE - 1);
+
+#if defined(_WIN32)
+  // if huge pages come from the locked large page pool
+  if (mode == MEMORY_HUGE_PAGES_EXPLICIT)
+  {
+    void* memory = VirtualAlloc(NULL, hugeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+
+    // if the large pages were available
+    if (memory)
+    {
+      *base = memory;
+      *mappedSize = hugeSize;
+      return memory;
+    }
+  }
+
+  // reserve enough to find an aligned range and only commit that range
+  char* reserved = (char*)(VirtualAlloc(NULL, size + CHUNK_SIZE, MEM_RESERVE, PAGE_NOACCESS));
+
+  // if the address space could not be reserved
+  if (reserved == NULL)
+  {
+    return NULL;
+  }
+
+  char* aligned = (char*)(((uintptr_t)(reserved) + CHUNK_SIZE - 1) & ~(uintptr_t)(CHUNK_SIZE - 1));
+
+  // if the range could not be committed
+  if (VirtualAlloc(aligned, size, MEM_COMMIT, PAGE_READWRITE) == NULL)
+  {
+    VirtualFree(reserved, 0, MEM_RELEASE);
+    return NULL;
+  }
+
+  *base = reserved;  // a reservation can only be released from its start
+  *mappedSize = size + CHUNK_SIZE;
+
+  return aligned;
+#else
+  #if defined(MAP_HUGETLB)
+  // if huge pages come from the reserved pool
+  if (mode == MEMORY_HUGE_PAGES_EXPLICIT)
+  {
+    void* memory = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    // if the pool had enough huge pages
+    if (memory != MAP_FAILED)
+    {
+      *base = memory;
+      *mappedSize = hugeSize;
+      return memory;
+    }
+  }
+  #endif
+
+  // map a chunk more than needed so an aligned range can be cut out of it
+  char* mapped = (char*)(mmap(NULL, size + CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+  // if the memory could not be mapped
+  if (mapped == (char*)(MAP_FAILED))
+  {
+    return NULL;
+  }
+
+  char* aligned = (char*)(((uintptr_t)(mapped) + CHUNK_SIZE - 1) & ~(uintptr_t)(CHUNK_SIZE - 1));
+  char* end = mapped + size + CHUNK_SIZE;
+
+  // if there is space in front of the aligned range
+  if (aligned != mapped)
+  {
+    munmap(mapped, aligned - mapped);
+  }
+
+  // if there is space behind the aligned range
+  if (end != aligned + size)
+  {
+    munmap(aligned + size, end - (aligned + size));
+  }
+
+  #if defined(MADV_HUGEPAGE)
+  // if huge pages were asked for at all
+  if (mode != MEMORY_HUGE_PAGES_OFF)
+  {
+    madvise(aligned, size, MADV_HUGEPAGE);
+  }
+  #endif
+
+  *base = aligned;  // the trimmed ends are already unmapped
+  *mappedSize = size;
+
+  return aligned;
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Gives memory from MapSystem back to the system
+
+\param base
+  the memory returned by MapSystem
+
+\param size
+  the mapped size MapSystem reported
+******************************************************************************/
+static void UnmapSystem(void* base, size_t size)
+{
+#if defined(_WIN32)
+  size;
+  VirtualFree(base, 0, MEM_RELEASE);
+#else
+  munmap(base, size);
+#endif
+}
@@ -0,0 +1,84 @@
+/*!****************************************************************************
+\file     MemoryPageSource.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the MemoryPageSource class, which gets memory for pages straight
+  from the operating system
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryManager.h"
+#include "MemoryAllocator.h"
+#include <stddef.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t CHUNK_SIZE = size_t(2) << 20;  //!< chunks are mapped 2 MiB at a time on 2 MiB boundaries, the size of a huge page
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! Maps chunks of memory from the operating system and carves pages out of
+//! them front to back. Pages are never given back one at a time, every chunk
+//! is unmapped at once by Release
+class MemoryPageSource
+{
+  public:
+
+    MemoryPageSource(void);
+    ~MemoryPageSource(void) = default;
+
+    static void SetHugePages(MemoryHugePages mode);
+
+    static void* MapDirect(size_t size);
+    static void UnmapDirect(void* ptr, size_t size);
+    static void* RemapDirect(void* ptr, size_t oldSize, size_t newSize);
+    static bool Purge(void* ptr, size_t size);
+
+    void* Allocate(size_t size);
+    void Release(void);
+
+    MemoryPageSource& operator=(const MemoryPageSource& rhs) = default;
+
+  private:
+
+    //! A range of memory mapped from the system
+    struct Chunk
+    {
+      void* base;   //!< the address the system returned
+      size_t size;  //!< the number of bytes mapped
+    };
+
+    char* mCursor;  //!< the start of the unused part of the current chunk
+    char* mEnd;     //!< the end of the current chunk
+
+    std::vector<Chunk, MemoryPageAllocator<Chunk>> mChunks; //!< every mapping, unmapped by Release
+
+    void* Map(size_t size);
+};
@@ -0,0 +1,784 @@
+/*!****************************************************************************
+\file     MemoryProfile.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all MemoryProfile class functions. The tables
+  are mapped straight from the system, so taking a sample never allocates
+  from the manager it is called from
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryProfile.h"
+#include <inttypes.h>
+#include <string.h>
+#include <chrono>
+#include <cmath>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <stdlib.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+const size_t PROFILE_MAX_STACK_COUNT = PROFILE_STACKS / 4 * 3;    //!< the call stacks kept before new ones are dropped
+const size_t PROFILE_MAX_SAMPLE_COUNT = PROFILE_SAMPLES / 4 * 3;  //!< the live samples kept before new ones are dropped
+const unsigned int PROFILE_SAMPLE_BITS = 16;                      //!< the bits of a block's hash that pick its slot
+
+static_assert((PROFILE_STACKS & (PROFILE_STACKS - 1)) == 0, "call stacks are found by masking their hash");
+static_assert((size_t(1) << PROFILE_SAMPLE_BITS) == PROFILE_SAMPLES, "samples are found by the top bits of their hash");
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+//! A sampled block that has not been freed yet
+struct ProfileSample
+{
+  const void* ptr;  //!< the block, NULL for an unused slot
+  size_t stack;     //!< the slot of the call stack that allocated it
+  size_t size;      //!< the bytes asked for
+};
+
+//! The countdown of the calling thread, plain data so it needs no constructor
+//! that could run inside an allocation
+struct ProfileThread
+{
+  size_t untilSample; //!< the bytes left to allocate before the next sample
+  uint64_t random;    //!< the state of the thread's random numbers, never 0 once drawn from
+  uint32_t session;   //!< the profile the countdown belongs to, 0 before the thread first allocates
+  bool busy;          //!< true while the thread takes a sample, the allocations that makes are not counted
+};
+
+//-----------------------------------------------------------------------------
+// Private Function Declerations
+//-----------------------------------------------------------------------------
+
+static size_t NextInterval(ProfileThread& thread, size_t rate);
+static size_t SampleHome(const void* ptr);
+static size_t CaptureStack(void** frames, size_t max);
+static double SampleScale(size_t count, size_t bytes, size_t rate);
+static void WriteFrame(FILE* file, void* frame);
+
+//-----------------------------------------------------------------------------
+// Private Variables
+//-----------------------------------------------------------------------------
+
+static thread_local ProfileThread profileThread;  //!< the countdown of the calling thread
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryProfile
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Stops sampling and writes the profile if DumpOnExit asked for it. The
+  tables stay mapped, a thread still running could be freeing a sample
+******************************************************************************/
+MemoryProfile::~MemoryProfile(void)
+{
+  Stop();
+
+  // if the profile should be written when the program exits
+  if (mExitPath)
+  {
+    FILE* file = fopen(mExitPath, "w");
+
+    // if the file could be created
+    if (file)
+    {
+      Dump(file, MEMORY_PROFILE_PPROF);
+      fclose(file);
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Throws away the samples of an earlier profile and starts sampling
+
+\param rate
+  the average bytes allocated between samples
+
+\return
+  true if sampling started, false if rate was 0 or the tables could not be
+  mapped
+******************************************************************************/
+bool MemoryProfile::Start(size_t rate)
+{
+  // if nothing would ever be sampled
+  if (rate == 0)
+  {
+    return false;
+  }
+
+  void* frames[PROFILE_MAX_DEPTH];
+
+  // the first capture loads the unwinder, which allocates, so it is done here
+  // and not while a sample holds the lock
+  CaptureStack(frames, PROFILE_MAX_DEPTH);
+
+  std::lock_guard<std::mutex> lock(mLock);
+
+  // if the tables have not been mapped yet, fresh pages are already zeroed
+  if (mStacks == NULL)
+  {
+    void* stacks = MemoryManagerMapPages(PROFILE_STACKS * sizeof(MemoryProfileStack));
+    void* samples = MemoryManagerMapPages(PROFILE_SAMPLES * sizeof(ProfileSample));
+    void* homes = MemoryManagerMapPages(PROFILE_SAMPLES * sizeof(std::atomic<uint16_t>));
+
+    // if any of the tables could not be mapped
+    if (stacks == NULL || samples == NULL || homes == NULL)
+    {
+      // if the stacks were mapped
+      if (stacks)
+      {
+        MemoryManagerUnmapPages(stacks, PROFILE_STACKS * sizeof(MemoryProfileStack));
+      }
+
+      // if the samples were mapped
+      if (samples)
+      {
+        MemoryManagerUnmapPages(samples, PROFILE_SAMPLES * sizeof(ProfileSample));
+      }
+
+      // if the homes were mapped
+      if (homes)
+      {
+        MemoryManagerUnmapPages(homes, PROFILE_SAMPLES * sizeof(std::atomic<uint16_t>));
+      }
+
+      return false;
+    }
+
+    mStacks = (MemoryProfileStack*)(stacks);
+    mSamples = (ProfileSample*)(samples);
+    mHomes = (std::atomic<uint16_t>*)(homes);
+  }
+  else
+  {
+    memset(mStacks, 0, PROFILE_STACKS * sizeof(MemoryProfileStack));
+    memset(mSamples, 0, PROFILE_SAMPLES * sizeof(ProfileSample));
+
+    // for all slots
+    for (size_t i = 0; i < PROFILE_SAMPLES; ++i)
+    {
+      mHomes[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  mStackCount = 0;
+  mSampleCount = 0;
+  mDropped = 0;
+  mRate.store(rate, std::memory_order_relaxed);
+  mSession.fetch_add(1, std::memory_order_relaxed);  // every thread draws a new countdown on its next allocation
+  mEnabled.store(true, std::memory_order_release);
+
+  return true;
+}
+
+/*!****************************************************************************
+\brief
+  Stops sampling, the profile keeps what it holds until the next Start. Blocks
+  freed from now on still count as live in it
+******************************************************************************/
+void MemoryProfile::Stop(void)
+{
+  mEnabled.store(false, std::memory_order_relaxed);
+}
+
+/*!****************************************************************************
+\brief
+  Writes the profile. The call stacks are copied out under the lock and
+  written after it is released, the file functions may allocate
+
+\param file
+  the file to write to
+
+\param format
+  the text heap profile pprof reads, or folded stacks of the live or of all
+  sampled bytes, scaled up to an estimate of the bytes they stand for
+
+\return
+  true if the profile was written, false if no profile was ever started
+******************************************************************************/
+bool MemoryProfile::Dump(FILE* file, MemoryProfileFormat format)
+{
+  MemoryProfileStack* stacks = NULL;
+  size_t count = 0;
+  size_t rate;
+  size_t dropped;
+
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    // if a profile was never started
+    if (mStacks == NULL)
+    {
+      return false;
+    }
+
+    rate = mRate.load(std::memory_order_relaxed);
+    dropped = mDropped;
+
+    // if any call stack was sampled
+    if (mStackCount)
+    {
+      stacks = (MemoryProfileStack*)(MemoryManagerMapPages(mStackCount * sizeof(MemoryProfileStack)));
+
+      // if there is no memory for the copy
+      if (stacks == NULL)
+      {
+        return false;
+      }
+
+      // for all slots, every used one is copied so count ends at mStackCount
+      for (size_t i = 0; i < PROFILE_STACKS; ++i)
+      {
+        // if the slot holds a call stack
+        if (mStacks[i].hash)
+        {
+          stacks[count++] = mStacks[i];
+        }
+      }
+    }
+  }
+
+  // if the profile is for pprof
+  if (format == MEMORY_PROFILE_PPROF)
+  {
+    MemoryProfileStack totals = MemoryProfileStack();
+
+    // for all call stacks
+    for (size_t i = 0; i < count; ++i)
+    {
+      totals.liveCount += stacks[i].liveCount;
+      totals.liveBytes += stacks[i].liveBytes;
+      totals.totalCount += stacks[i].totalCount;
+      totals.totalBytes += stacks[i].totalBytes;
+    }
+
+    // pprof scales the raw samples up by the rate in the header itself
+    fprintf(file, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+            totals.liveCount, totals.liveBytes, totals.totalCount, totals.totalBytes, rate);
+
+    // for all call stacks
+    for (size_t i = 0; i < count; ++i)
+    {
+      const MemoryProfileStack& stack = stacks[i];
+
+      fprintf(file, "%zu: %zu [%zu: %zu] @", stack.liveCount, stack.liveBytes, stack.totalCount, stack.totalBytes);
+
+      // for all frames, the innermost first
+      for (size_t j = 0; j < stack.depth; ++j)
+      {
+        fprintf(file, " 0x%" PRIxPTR, (uintptr_t)(stack.frames[j]));
+      }
+
+      fputc('\n', file);
+    }
+
+    // if samples were lost, the profile only covers part of the heap
+    if (dropped)
+    {
+      fprintf(file, "# %zu samples dropped, the profile tables were full\n", dropped);
+    }
+
+#if !defined(_WIN32)
+    FILE* maps = fopen("/proc/self/maps", "r");
+
+    // if the mappings can be read, pprof needs them to find the symbols
+    if (maps)
+    {
+      char buffer[4096];
+      size_t read;
+
+      fputs("\nMAPPED_LIBRARIES:\n", file);
+
+      // while there is more of the mappings to copy
+      while ((read = fread(buffer, 1, sizeof(buffer), maps)) > 0)
+      {
+        fwrite(buffer, 1, read, file);
+      }
+
+      fclose(maps);
+    }
+#endif
+  }
+  else
+  {
+    bool live = format == MEMORY_PROFILE_FOLDED_LIVE;
+
+    // for all call stacks
+    for (size_t i = 0; i < count; ++i)
+    {
+      const MemoryProfileStack& stack = stacks[i];
+      size_t samples = live ? stack.liveCount : stack.totalCount;
+      size_t bytes = live ? stack.liveBytes : stack.totalBytes;
+
+      // if the call stack holds nothing
+      if (samples == 0)
+      {
+        continue;
+      }
+
+      // for all frames, the outermost first as flame graphs expect
+      for (size_t j = stack.depth; j > 0; --j)
+      {
+        WriteFrame(file, stack.frames[j - 1]);
+        fputc(j > 1 ? ';' : ' ', file);
+      }
+
+      fprintf(file, "%zu\n", (size_t)(bytes * SampleScale(samples, bytes, rate) + 0.5));
+    }
+  }
+
+  // if there is a copy to give back
+  if (stacks)
+  {
+    MemoryManagerUnmapPages(stacks, count * sizeof(MemoryProfileStack));
+  }
+
+  return true;
+}
+
+/*!****************************************************************************
+\brief
+  Writes the profile in the pprof format when the program exits
+
+\param path
+  the file to write, it must stay valid until then
+******************************************************************************/
+void MemoryProfile::DumpOnExit(const char* path)
+{
+  mExitPath = path;
+}
+
+/*!****************************************************************************
+\brief
+  Counts a block against the calling thread's countdown and samples it when
+  the countdown runs out. Only call it while Enabled returns true
+
+\param size
+  the bytes asked for
+
+\param ptr
+  the block
+******************************************************************************/
+void MemoryProfile::Allocated(size_t size, const void* ptr)
+{
+  ProfileThread& thread = profileThread;
+
+  // if the block was allocated while the thread was taking a sample
+  if (thread.busy)
+  {
+    return;
+  }
+
+  size_t rate = mRate.load(std::memory_order_relaxed);
+  uint32_t session = mSession.load(std::memory_order_relaxed);
+
+  // if the thread has not allocated since the profile started
+  if (thread.session != session)
+  {
+    thread.session = session;
+    thread.random = ((uint64_t)(uintptr_t)(&thread) ^ (uint64_t)(std::chrono::steady_clock::now().time_since_epoch().count())) | 1;
+    thread.untilSample = NextInterval(thread, rate);
+  }
+
+  // if the countdown has not run out
+  if (size < thread.untilSample)
+  {
+    thread.untilSample -= size;
+    return;
+  }
+
+  thread.untilSample = NextInterval(thread, rate);
+  thread.busy = true;
+  TakeSample(size, ptr);
+  thread.busy = false;
+}
+
+/*!****************************************************************************
+\brief
+  Forgets a block if it was sampled. Only takes the lock if some sample
+  starts its search at the block's slot, which few blocks share
+
+\param ptr
+  the block being freed
+******************************************************************************/
+void MemoryProfile::Destroyed(const void* ptr)
+{
+  size_t home = SampleHome(ptr);
+
+  // if no sample could be in the block's slots
+  if (mHomes[home].load(std::memory_order_relaxed) == 0)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mLock);
+
+  // for all slots from the block's until an unused one
+  for (size_t i = home; mSamples[i].ptr; i = (i + 1) & (PROFILE_SAMPLES - 1))
+  {
+    // if the slot holds the block
+    if (mSamples[i].ptr == ptr)
+    {
+      RemoveSample(i);
+      return;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Records a sampled block under the call stack that allocated it
+
+\param size
+  the bytes asked for
+
+\param ptr
+  the block
+******************************************************************************/
+void MemoryProfile::TakeSample(size_t size, const void* ptr)
+{
+  void* frames[PROFILE_MAX_DEPTH];
+  size_t depth = CaptureStack(frames, PROFILE_MAX_DEPTH);
+
+  std::lock_guard<std::mutex> lock(mLock);
+
+  size_t index = SampleHome(ptr);
+
+  // for all slots from the block's until an unused one
+  while (mSamples[index].ptr)
+  {
+    // if the block is still sampled, it was freed in a way that was not seen
+    if (mSamples[index].ptr == ptr)
+    {
+      RemoveSample(index);
+      index = SampleHome(ptr);
+      continue;
+    }
+
+    index = (index + 1) & (PROFILE_SAMPLES - 1);
+  }
+
+  size_t stack = (mSampleCount < PROFILE_MAX_SAMPLE_COUNT) ? FindStack(frames, depth) : PROFILE_STACKS;
+
+  // if either table is full
+  if (stack == PROFILE_STACKS)
+  {
+    ++mDropped;
+    return;
+  }
+
+  mSamples[index].ptr = ptr;
+  mSamples[index].stack = stack;
+  mSamples[index].size = size;
+  mHomes[SampleHome(ptr)].fetch_add(1, std::memory_order_relaxed);
+  ++mSampleCount;
+
+  MemoryProfileStack& entry = mStacks[stack];
+
+  ++entry.liveCount;
+  entry.liveBytes += size;
+  ++entry.totalCount;
+  entry.totalBytes += size;
+}
+
+/*!****************************************************************************
+\brief
+  Finds the slot of a call stack, adding it if it is new. Only call it with
+  the lock held
+
+\param frames
+  the return addresses, the innermost first
+
+\param depth
+  the number of frames
+
+\return
+  the slot of the call stack, PROFILE_STACKS if it is new and the table is full
+******************************************************************************/
+size_t MemoryProfile::FindStack(void* const* frames, size_t depth)
+{
+  uint64_t hash = 14695981039346656037ull;
+
+  // for all frames
+  for (size_t i = 0; i < depth; ++i)
+  {
+    hash = (hash ^ (uint64_t)(uintptr_t)(frames[i])) * 1099511628211ull;
+  }
+
+  // if the hash is the one that marks an unused slot
+  if (hash == 0)
+  {
+    hash = 1;
+  }
+
+  size_t index = (size_t)(hash) & (PROFILE_STACKS - 1);
+
+  // for all slots from the hash's until an unused one
+  while (mStacks[index].hash)
+  {
+    const MemoryProfileStack& stack = mStacks[index];
+
+    // if the slot holds the same frames
+    if (stack.hash == hash && stack.depth == depth && memcmp(stack.frames, frames, depth * sizeof(void*)) == 0)
+    {
+      return index;
+    }
+
+    index = (index + 1) & (PROFILE_STACKS - 1);
+  }
+
+  // if the table is full
+  if (mStackCount >= PROFILE_MAX_STACK_COUNT)
+  {
+    return PROFILE_STACKS;
+  }
+
+  MemoryProfileStack& stack = mStacks[index];
+
+  stack.hash = hash;
+  stack.depth = depth;
+  memcpy(stack.frames, frames, depth * sizeof(void*));
+  ++mStackCount;
+
+  return index;
+}
+
+/*!****************************************************************************
+\brief
+  Takes a freed block out of the samples. Later samples of the same run of
+  slots are shifted back into the hole, so a search never stops early. Only
+  call it with the lock held
+
+\param index
+  the slot of the block
+******************************************************************************/
+void MemoryProfile::RemoveSample(size_t index)
+{
+  ProfileSample& sample = mSamples[index];
+  MemoryProfileStack& stack = mStacks[sample.stack];
+
+  --stack.liveCount;
+  stack.liveBytes -= sample.size;
+  mHomes[SampleHome(sample.ptr)].fetch_sub(1, std::memory_order_relaxed);
+  --mSampleCount;
+
+  size_t hole = index;
+
+  // for all slots after the hole until an unused one
+  for (size_t i = (index + 1) & (PROFILE_SAMPLES - 1); mSamples[i].ptr; i = (i + 1) & (PROFILE_SAMPLES - 1))
+  {
+    size_t home = SampleHome(mSamples[i].ptr);
+
+    // if the sample's search would pass the hole before reaching it
+    if (((i - home) & (PROFILE_SAMPLES - 1)) >= ((i - hole) & (PROFILE_SAMPLES - 1)))
+    {
+      mSamples[hole] = mSamples[i];
+      hole = i;
+    }
+  }
+
+  mSamples[hole].ptr = NULL;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Draws the bytes until the next sample from an exponential distribution, so
+  every byte allocated has the same chance of being the one sampled
+
+\param thread
+  the countdown whose random numbers are used
+
+\param rate
+  the average bytes between samples
+
+\return
+  the bytes to allocate before the next sample, at least 1
+******************************************************************************/
+static size_t NextInterval(ProfileThread& thread, size_t rate)
+{
+  // xorshift64*, plenty for spacing samples
+  thread.random ^= thread.random >> 12;
+  thread.random ^= thread.random << 25;
+  thread.random ^= thread.random >> 27;
+
+  uint64_t bits = thread.random * 2685821657736338717ull;
+  double uniform = (double)((bits >> 11) + 1) * (1.0 / 9007199254740992.0);  // in (0, 1], so the log is finite
+  double interval = -std::log(uniform) * (double)(rate);
+
+  // if the draw is below a single byte
+  if (interval < 1.0)
+  {
+    return 1;
+  }
+
+  return (interval < (double)(SIZE_MAX)) ? (size_t)(interval) : SIZE_MAX;
+}
+
+/*!****************************************************************************
+\brief
+  Finds the slot a block's search starts at
+
+\param ptr
+  the block
+
+\return
+  the slot in the samples and in the homes
+******************************************************************************/
+static size_t SampleHome(const void* ptr)
+{
+  return (size_t)(((uint64_t)(uintptr_t)(ptr) * 0x9E3779B97F4A7C15ull) >> (64 - PROFILE_SAMPLE_BITS));
+}
+
+/*!****************************************************************************
+\brief
+  Reads the return addresses of the calling thread. The frames of the
+  profiler and the manager stay at the innermost end of the stack
+
+\param frames
+  filled with the return addresses, the innermost first
+
+\param max
+  the most frames to read
+
+\return
+  the number of frames read
+******************************************************************************/
+static size_t CaptureStack(void** frames, size_t max)
+{
+#if defined(_WIN32)
+  return CaptureStackBackTrace(1, (DWORD)(max), frames, NULL);
+#else
+  void* all[PROFILE_MAX_DEPTH + 1];
+  int count = backtrace(all, (int)(max < PROFILE_MAX_DEPTH ? max : PROFILE_MAX_DEPTH) + 1);
+
+  // if there is nothing past this function's own frame
+  if (count <= 1)
+  {
+    return 0;
+  }
+
+  memcpy(frames, all + 1, (count - 1) * sizeof(void*));
+
+  return (size_t)(count - 1);
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Finds how many bytes a call stack's sampled bytes stand for. A block of
+  the average size was sampled with a chance of 1 - e^(-size / rate)
+
+\param count
+  the blocks the call stack has allocated that were sampled
+
+\param bytes
+  the bytes asked for by those blocks
+
+\param rate
+  the average bytes between samples
+
+\return
+  the factor to multiply sampled bytes by
+******************************************************************************/
+static double SampleScale(size_t count, size_t bytes, size_t rate)
+{
+  // if nothing was sampled
+  if (count == 0 || bytes == 0)
+  {
+    return 0.0;
+  }
+
+  double average = (double)(bytes) / (double)(count);
+
+  return 1.0 / (1.0 - std::exp(-average / (double)(rate)));
+}
+
+/*!****************************************************************************
+\brief
+  Writes a frame of a folded stack, the name of its function when the system
+  knows it, else the module and offset or the bare address
+
+\param file
+  the file to write to
+
+\param frame
+  the return address
+******************************************************************************/
+static void WriteFrame(FILE* file, void* frame)
+{
+#if !defined(_WIN32)
+  Dl_info info;
+
+  // a return address points past the call, one byte back is inside it
+  if (dladdr((char*)(frame) - 1, &info))
+  {
+    // if the function has a name
+    if (info.dli_sname)
+    {
+      int status;
+      char* name = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+
+      fputs(status == 0 ? name : info.dli_sname, file);
+      free(name);
+      return;
+    }
+
+    // if the module has a name
+    if (info.dli_fname)
+    {
+      const char* module = strrchr(info.dli_fname, '/');
+
+      fprintf(file, "%s+0x%" PRIxPTR, module ? module + 1 : info.dli_fname, (uintptr_t)(frame) - (uintptr_t)(info.dli_fbase));
+      return;
+    }
+  }
+#endif
+
+  fprintf(file, "0x%" PRIxPTR, (uintptr_t)(frame));
+}
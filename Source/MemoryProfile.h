@@ -0,0 +1,107 @@
+/*!****************************************************************************
+\file     MemoryProfile.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the MemoryProfile class, which samples allocations with their call
+  stacks so the code paths holding memory can be found without a full trace
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryManager.h"
+#include <atomic>
+#include <mutex>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+struct ProfileSample;
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t PROFILE_MAX_DEPTH = 32;      //!< the most frames kept of a call stack, the outermost are cut off
+const size_t PROFILE_STACKS = 4096;       //!< the slots for distinct call stacks, at most three quarters are used
+const size_t PROFILE_SAMPLES = 65536;     //!< the slots for sampled blocks not freed yet, at most three quarters are used
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! A call stack that allocated at least one sampled block, with the sampled
+//! blocks it still holds and every one it has allocated since the start
+struct MemoryProfileStack
+{
+  uint64_t hash;                    //!< the hash of the frames, 0 for an unused slot
+  size_t depth;                     //!< the frames in use
+  size_t liveCount;                 //!< the sampled blocks not freed yet
+  size_t liveBytes;                 //!< the bytes asked for by those blocks
+  size_t totalCount;                //!< every sampled block
+  size_t totalBytes;                //!< the bytes asked for by every sampled block
+  void* frames[PROFILE_MAX_DEPTH];  //!< return addresses, the innermost first
+};
+
+//! Samples about one allocation per given number of bytes. Every thread
+//! counts down a random number of bytes drawn so the gaps between samples
+//! follow a Poisson process, big blocks are sampled more often than small
+//! ones in proportion to their size. Sampled blocks are kept with their call
+//! stack until they are freed. A free only takes the lock when a counter for
+//! the block's slot says a sample may be there, so profiling costs a relaxed
+//! load per call while it is off and little more while it is on
+class MemoryProfile
+{
+  public:
+
+    constexpr MemoryProfile(void) : mEnabled(false), mSession(0), mRate(0), mLock(), mStacks(NULL), mSamples(NULL),
+                                    mHomes(NULL), mStackCount(0), mSampleCount(0), mDropped(0), mExitPath(NULL) {}
+    ~MemoryProfile(void);
+
+    bool Start(size_t rate);
+    void Stop(void);
+    bool Dump(FILE* file, MemoryProfileFormat format);
+    void DumpOnExit(const char* path);
+
+    //! Checks whether allocations are being sampled, a single load so the
+    //! check costs nothing noticeable while profiling is off
+    bool Enabled(void) const { return mEnabled.load(std::memory_order_acquire); }
+
+    void Allocated(size_t size, const void* ptr);
+    void Destroyed(const void* ptr);
+
+  private:
+
+    std::atomic<bool> mEnabled;           //!< true while allocations are sampled
+    std::atomic<uint32_t> mSession;       //!< changed on every Start so threads draw a new countdown
+    std::atomic<size_t> mRate;            //!< the average bytes allocated between samples
+    std::mutex mLock;                     //!< guards the tables and the counts below
+    MemoryProfileStack* mStacks;          //!< the call stacks, found by their hash
+    ProfileSample* mSamples;              //!< the sampled blocks, found by their address
+    std::atomic<uint16_t>* mHomes;        //!< the samples whose search starts at each slot, read without the lock
+    size_t mStackCount;                   //!< the call stacks in mStacks
+    size_t mSampleCount;                  //!< the sampled blocks in mSamples
+    size_t mDropped;                      //!< the samples lost because a table was full
+    const char* mExitPath;                //!< the file the profile is written to when the program exits, NULL for none
+
+    void TakeSample(size_t size, const void* ptr);
+    size_t FindStack(void* const* frames, size_t depth);
+    void RemoveSample(size_t index);
+};
@@ -0,0 +1,498 @@
+/*!****************************************************************************
+\file     MemoryResource.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all memory_resource adapter functions
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryResource.h"
+#include "MemoryManager.h"
+#include <new>
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Gets a resource backed by the manager, for std::pmr::set_default_resource
+  or any container that should allocate from the manager
+
+\return
+  the resource, it lives until the program ends
+******************************************************************************/
+std::pmr::memory_resource* MemoryManagerGetResource(void)
+{
+  static MemoryManagerResource resource;
+
+  return &resource;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryManagerResource
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Allocates from the thread cache, or from an arena when the alignment is
+  more than every block already has
+
+\param bytes
+  the number of bytes to allocate
+
+\param alignment
+  a power of two the address must be a multiple of
+
+\return
+  a pointer to the allocated memory
+******************************************************************************/
+void* MemoryManagerResource::do_allocate(size_t bytes, size_t alignment)
+{
+  // if every block is already aligned enough
+  if (alignment <= BIN_ALIGNMENT)
+  {
+    return Alloc(bytes);
+  }
+
+  return AllocAligned(bytes, alignment);
+}
+
+/*!****************************************************************************
+\brief
+  Gives memory back through the sized Delete, containers always pass the
+  size they allocated with so the block's header is never read
+
+\param ptr
+  the memory to free
+
+\param bytes
+  the size passed to do_allocate
+
+\param alignment
+  the alignment passed to do_allocate
+******************************************************************************/
+void MemoryManagerResource::do_deallocate(void* ptr, size_t bytes, size_t /* alignment */)
+{
+  Delete(ptr, bytes);
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether memory from this resource can be freed by another
+
+\param other
+  the resource to compare with
+
+\return
+  true if other also allocates from the manager, else false
+******************************************************************************/
+bool MemoryManagerResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return dynamic_cast<const MemoryManagerResource*>(&other) != NULL;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryHeapResource
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Makes a resource that allocates from one arena of the manager
+
+\param heap
+  the index of the arena, less than MemoryManagerArenaCount()
+******************************************************************************/
+MemoryHeapResource::MemoryHeapResource(unsigned int heap) :
+                                       mHeap(heap)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Gets the arena allocations come from
+
+\return
+  the index of the arena
+******************************************************************************/
+unsigned int MemoryHeapResource::Heap(void) const
+{
+  return mHeap;
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+void* MemoryHeapResource::do_allocate(size_t bytes, size_t alignment)
+{
+  return MemoryManagerHeapAlloc(mHeap, bytes, alignment);
+}
+
+void MemoryHeapResource::do_deallocate(void* ptr, size_t /* bytes */, size_t /* alignment */)
+{
+  MemoryManagerHeapDelete(ptr);
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether memory from this resource can be freed by another, any heap
+  resource frees into the arena that owns the block
+
+\param other
+  the resource to compare with
+
+\return
+  true if other is a heap resource, else false
+******************************************************************************/
+bool MemoryHeapResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return dynamic_cast<const MemoryHeapResource*>(&other) != NULL;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: ArenaResource
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+ArenaResource::ArenaResource(Arena& arena) :
+                             mArena(arena)
+{
+}
+
+Arena& ArenaResource::GetArena(void) const
+{
+  return mArena;
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+void* ArenaResource::do_allocate(size_t bytes, size_t alignment)
+{
+  return mArena.Allocate(bytes, alignment);
+}
+
+/*!****************************************************************************
+\brief
+  Does nothing, the memory is freed when the arena is reset
+******************************************************************************/
+void ArenaResource::do_deallocate(void* /* ptr */, size_t /* bytes */, size_t /* alignment */)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether memory from this resource can be freed by another
+
+\param other
+  the resource to compare with
+
+\return
+  true if other allocates from the same arena, else false
+******************************************************************************/
+bool ArenaResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  const ArenaResource* arena = dynamic_cast<const ArenaResource*>(&other);
+
+  return arena != NULL && &arena->mArena == &mArena;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryPoolResource
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+MemoryPoolResource::MemoryPoolResource(void) :
+                                       mFree(),
+                                       mChunks(NULL),
+                                       mLarge(NULL)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Gives every chunk back to the manager
+******************************************************************************/
+MemoryPoolResource::~MemoryPoolResource(void)
+{
+  Release();
+}
+
+/*!****************************************************************************
+\brief
+  Gives every chunk back to the manager at once, every block handed out from
+  the pool's size classes is freed with them. Blocks that went straight to
+  the manager are freed one by one
+******************************************************************************/
+void MemoryPoolResource::Release(void)
+{
+  // while there are blocks from the manager left
+  while (mLarge)
+  {
+    Large* next = mLarge->next;
+
+    Delete(mLarge);
+    mLarge = next;
+  }
+
+  // while there are chunks left
+  while (mChunks)
+  {
+    Chunk* next = mChunks->next;
+
+    Delete(mChunks, POOL_RESOURCE_CHUNK_SIZE);
+    mChunks = next;
+  }
+
+  // for all size classes
+  for (void*& list : mFree)
+  {
+    list = NULL;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Pops a block from the free list of the size class that holds the request,
+  an empty list is refilled from a new chunk
+
+\param bytes
+  the number of bytes to allocate
+
+\param alignment
+  a power of two the address must be a multiple of
+
+\return
+  a pointer to the allocated memory
+******************************************************************************/
+void* MemoryPoolResource::do_allocate(size_t bytes, size_t alignment)
+{
+  // if the request can not come from a size class
+  if (bytes > CACHE_MAX_SIZE || alignment > BIN_ALIGNMENT)
+  {
+    return AllocateLarge(bytes, alignment);
+  }
+
+  size_t index = MemoryBins::ClassIndex(bytes);
+  void* block = mFree[index];
+
+  // if the size class has no free blocks
+  if (block == NULL)
+  {
+    return Refill(index);
+  }
+
+  mFree[index] = *(void**)(block);
+
+  return block;
+}
+
+/*!****************************************************************************
+\brief
+  Pushes a block onto the free list of its size class
+
+\param ptr
+  the memory to free
+
+\param bytes
+  the size passed to do_allocate
+
+\param alignment
+  the alignment passed to do_allocate
+******************************************************************************/
+void MemoryPoolResource::do_deallocate(void* ptr, size_t bytes, size_t alignment)
+{
+  // if the block came straight from the manager
+  if (bytes > CACHE_MAX_SIZE || alignment > BIN_ALIGNMENT)
+  {
+    DestroyLarge(ptr, alignment);
+    return;
+  }
+
+  size_t index = MemoryBins::ClassIndex(bytes);
+
+  *(void**)(ptr) = mFree[index];
+  mFree[index] = ptr;
+}
+
+bool MemoryPoolResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+/*!****************************************************************************
+\brief
+  Takes a chunk from the manager and carves it into blocks of a size class,
+  all but the first go on the free list of the class
+
+\param index
+  the size class to refill
+
+\return
+  the first block of the chunk
+******************************************************************************/
+void* MemoryPoolResource::Refill(size_t index)
+{
+  size_t size = MemoryBins::ClassSize(index);
+  Chunk* chunk = static_cast<Chunk*>(Alloc(POOL_RESOURCE_CHUNK_SIZE));
+
+  chunk->next = mChunks;
+  mChunks = chunk;
+
+  char* first = (char*)(chunk) + BIN_ALIGNMENT; // the link sits in front of the blocks
+  char* end = (char*)(chunk) + POOL_RESOURCE_CHUNK_SIZE - size;
+
+  // for all blocks after the first, last to first so the list runs forward
+  for (char* block = end - (end - first) % size; block > first; block -= size)
+  {
+    *(void**)(block) = mFree[index];
+    mFree[index] = block;
+  }
+
+  return first;
+}
+
+/*!****************************************************************************
+\brief
+  Allocates a block straight from the manager with a header in front that
+  links it into the pool's list, so Release can find it. If the memory is not
+  allocated, throws a bad_alloc exception
+
+\param bytes
+  the number of bytes to allocate
+
+\param alignment
+  a power of two the address must be a multiple of
+
+\return
+  a pointer to the allocated memory, just past the header
+******************************************************************************/
+void* MemoryPoolResource::AllocateLarge(size_t bytes, size_t alignment)
+{
+  alignment = (alignment > BIN_ALIGNMENT) ? alignment : BIN_ALIGNMENT;
+
+  size_t offset = (sizeof(Large) + alignment - 1) & ~(alignment - 1);  // the header padded so the block stays aligned
+
+  // if the header would not fit in the address space
+  if (bytes > SIZE_MAX - offset)
+  {
+    throw std::bad_alloc();
+  }
+
+  Large* large = static_cast<Large*>(AllocAligned(offset + bytes, alignment));
+
+  // if the alignment was not a power of two
+  if (large == NULL)
+  {
+    throw std::bad_alloc();
+  }
+
+  large->next = mLarge;
+  large->prev = NULL;
+
+  // if another block is on the list
+  if (mLarge)
+  {
+    mLarge->prev = large;
+  }
+
+  mLarge = large;
+
+  return (char*)(large) + offset;
+}
+
+/*!****************************************************************************
+\brief
+  Takes a block from AllocateLarge off the pool's list and frees it
+
+\param ptr
+  the memory to free
+
+\param alignment
+  the alignment passed to AllocateLarge
+******************************************************************************/
+void MemoryPoolResource::DestroyLarge(void* ptr, size_t alignment)
+{
+  alignment = (alignment > BIN_ALIGNMENT) ? alignment : BIN_ALIGNMENT;
+
+  size_t offset = (sizeof(Large) + alignment - 1) & ~(alignment - 1);
+  Large* large = (Large*)((char*)(ptr) - offset);
+
+  // if a newer block is on the list
+  if (large->prev)
+  {
+    large->prev->next = large->next;
+  }
+  else
+  {
+    mLarge = large->next;
+  }
+
+  // if an older block is on the list
+  if (large->next)
+  {
+    large->next->prev = large->prev;
+  }
+
+  Delete(large);
+}
+
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,145 @@
+/*!****************************************************************************
+\file     MemoryResource.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the std::pmr::memory_resource adapters that let pmr containers
+  allocate from the manager, from a single arena of the manager, from an
+  Arena or from a pool of the manager's size classes
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "Arena.h"
+#include "MemoryBins.h"
+#include "MemoryCache.h"
+#include <stddef.h>
+#include <memory_resource>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t POOL_RESOURCE_CHUNK_SIZE = 16 * 1024;  //!< the number of bytes a pool resource takes from the manager to carve a size class from
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+std::pmr::memory_resource* MemoryManagerGetResource(void);
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! Allocates from the manager through the thread cache, the same path as Alloc
+//! and the sized Delete. Every instance is interchangeable with every other
+class MemoryManagerResource : public std::pmr::memory_resource
+{
+  private:
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+//! Allocates from one arena of the manager without going through the thread
+//! cache, so the memory of a subsystem stays together and only contends for
+//! that arena's lock
+class MemoryHeapResource : public std::pmr::memory_resource
+{
+  public:
+
+    MemoryHeapResource(unsigned int heap);
+
+    unsigned int Heap(void) const;
+
+  private:
+
+    unsigned int mHeap; //!< the index of the arena allocations come from
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+//! Allocates from an Arena, deallocation does nothing and the memory comes
+//! back when the arena is reset. The arena must outlive the resource
+class ArenaResource : public std::pmr::memory_resource
+{
+  public:
+
+    ArenaResource(Arena& arena);
+
+    Arena& GetArena(void) const;
+
+  private:
+
+    Arena& mArena;  //!< the arena allocations come from
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+//! A pool for a single thread that rounds each request up to one of the
+//! manager's size classes and keeps a free list per class. Each class is
+//! carved from chunks taken from the manager, which all go back when the pool
+//! is released or destroyed. Requests too big for the thread cache or aligned
+//! past BIN_ALIGNMENT go straight to the manager, they are kept on a list so
+//! releasing the pool frees them too
+class MemoryPoolResource : public std::pmr::memory_resource
+{
+  public:
+
+    MemoryPoolResource(void);
+    ~MemoryPoolResource(void);
+
+    MemoryPoolResource(const MemoryPoolResource& rhs) = delete;
+    MemoryPoolResource& operator=(const MemoryPoolResource& rhs) = delete;
+
+    void Release(void);
+
+  private:
+
+    //! The start of every chunk taken from the manager
+    struct Chunk
+    {
+      Chunk* next;  //!< the chunk taken before this one
+    };
+
+    //! The header in front of every block that went straight to the manager
+    struct Large
+    {
+      Large* next;  //!< the block allocated before this one
+      Large* prev;  //!< the block allocated after this one, NULL for the newest
+    };
+
+    void* mFree[CACHE_CLASS_COUNT];   //!< the free blocks of each size class, linked through their memory
+    Chunk* mChunks;                   //!< every chunk, newest first
+    Large* mLarge;                    //!< every block that went straight to the manager and is not freed yet, newest first
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void* Refill(size_t index);
+    void* AllocateLarge(size_t bytes, size_t alignment);
+    void DestroyLarge(void* ptr, size_t alignment);
+};
@@ -0,0 +1,279 @@
+/*!****************************************************************************
+\file     MemorySlab.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all MemorySlab class functions
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemorySlab.h"
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemorySlab
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+MemorySlab::MemorySlab(void) :
+                       next(0),
+                       prev(0),
+                       page(0),
+                       lent(false),
+                       purged(false),
+                       idleSince(0),
+                       mPtr(NULL),
+                       mCursor(NULL),
+                       mEnd(NULL),
+                       mFree(NULL),
+                       mSize(0),
+                       mObjectSize(0),
+                       mUsed(0)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Makes a slab out of a page, no object is touched until it is handed out
+
+\param ptr
+  the start of the page
+
+\param size
+  the size of the page in bytes
+
+\param objectSize
+  the size class of the slab, at least large enough to hold a pointer
+******************************************************************************/
+MemorySlab::MemorySlab(void* ptr, size_t size, size_t objectSize) :
+                       next(0),
+                       prev(0),
+                       page(0),
+                       lent(false),
+                       purged(false),
+                       idleSince(0),
+                       mPtr((char*)(ptr)),
+                       mCursor((char*)(ptr)),
+                       mEnd((char*)(ptr) + size - size % objectSize),
+                       mFree(NULL),
+                       mSize((uint32_t)(size)),
+                       mObjectSize((uint32_t)(objectSize)),
+                       mUsed(0)
+{
+}
+
+/*!****************************************************************************
+\brief
+  Hands out an object, the slab must not be full
+
+\return
+  the object
+******************************************************************************/
+void* MemorySlab::Allocate(void)
+{
+  void* object = mFree;
+
+  // if an object was given back
+  if (object)
+  {
+    mFree = *(void**)(object);
+  }
+  else
+  {
+    object = mCursor;
+    mCursor += mObjectSize;
+  }
+
+  ++mUsed;
+
+  return object;
+}
+
+/*!****************************************************************************
+\brief
+  Hands out a number of objects at once, the free list is used first and
+  then a contiguous run from the untouched end of the page
+
+\param objects
+  filled with the objects handed out
+
+\param count
+  the most objects to hand out
+
+\return
+  the number of objects handed out, less than count if the slab filled up
+******************************************************************************/
+size_t MemorySlab::AllocateRun(void** objects, size_t count)
+{
+  size_t taken = 0;
+
+  // while there are objects that were given back
+  while (taken < count && mFree)
+  {
+    objects[taken++] = mFree;
+    mFree = *(void**)(mFree);
+  }
+
+  size_t fresh = (size_t)(mEnd - mCursor) / mObjectSize;
+
+  // if the untouched end holds more than is still needed
+  if (fresh > count - taken)
+  {
+    fresh = count - taken;
+  }
+
+  // for all objects carved from the untouched end
+  for (size_t i = 0; i < fresh; ++i)
+  {
+    objects[taken++] = mCursor;
+    mCursor += mObjectSize;
+  }
+
+  mUsed += (uint32_t)(taken);
+
+  return taken;
+}
+
+/*!****************************************************************************
+\brief
+  Takes back an object handed out by this slab. Once every object is back
+  the free list is dropped and the slab is carved from the start again, so
+  the next objects come out in address order without reading cold links
+
+\param object
+  the object to take back
+******************************************************************************/
+void MemorySlab::Destroy(void* object)
+{
+  // if that was the last object handed out
+  if (--mUsed == 0)
+  {
+    mFree = NULL;
+    mCursor = mPtr;
+    return;
+  }
+
+  *(void**)(object) = mFree;
+  mFree = object;
+}
+
+/*!****************************************************************************
+\brief
+  Takes back a list of objects handed out by this slab with one update of
+  the free list
+
+\param first
+  the first object of the list, each object links to the next through its
+  first bytes
+
+\param last
+  the last object of the list
+
+\param count
+  the number of objects in the list
+******************************************************************************/
+void MemorySlab::DestroyList(void* first, void* last, size_t count)
+{
+  mUsed -= (uint32_t)(count);
+
+  // if those were the last objects handed out
+  if (mUsed == 0)
+  {
+    mFree = NULL;
+    mCursor = mPtr;
+    return;
+  }
+
+  *(void**)(last) = mFree;
+  mFree = first;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether every object in the slab is handed out
+
+\return
+  true if Allocate can not be called, else false
+******************************************************************************/
+bool MemorySlab::Full(void) const
+{
+  return mFree == NULL && mCursor == mEnd;
+}
+
+bool MemorySlab::Empty(void) const
+{
+  return mUsed == 0;
+}
+
+/*!****************************************************************************
+\brief
+  Gets the number of objects handed out and not yet given back
+
+\return
+  the number of objects in use
+******************************************************************************/
+size_t MemorySlab::Used(void) const
+{
+  return mUsed;
+}
+
+size_t MemorySlab::ObjectSize(void) const
+{
+  return mObjectSize;
+}
+
+const void* MemorySlab::Ptr(void) const
+{
+  return mPtr;
+}
+
+/*!****************************************************************************
+\brief
+  Gets the size of the whole slab page, including the tail too small to be an
+  object
+
+\return
+  the size of the page in bytes
+******************************************************************************/
+size_t MemorySlab::Size(void) const
+{
+  return mSize;
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
@@ -0,0 +1,89 @@
+/*!****************************************************************************
+\file     MemorySlab.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the MemorySlab class, a page split into objects of a single small
+  size class that carry no header of their own
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t SLAB_SIZE = 16 * 1024;   //!< the bytes in a slab page, a whole number of granules
+const size_t SLAB_MAX_SIZE = 256;     //!< the largest size class served from slabs
+const size_t SLAB_CLASS_COUNT = 16;   //!< the number of size classes up to SLAB_MAX_SIZE
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! The descriptor of a slab page. The size class is recorded here once instead
+//! of in front of every object, objects are found from their address through
+//! the page map. Objects are handed out from the free list first and then from
+//! the untouched end of the page, so a fresh slab is never walked
+class MemorySlab
+{
+  public:
+
+    MemorySlab(void);
+    MemorySlab(void* ptr, size_t size, size_t objectSize);
+
+    ~MemorySlab(void) = default;
+
+    void* Allocate(void);
+    size_t AllocateRun(void** objects, size_t count);
+    void Destroy(void* object);
+    void DestroyList(void* first, void* last, size_t count);
+
+    bool Full(void) const;
+    bool Empty(void) const;
+
+    size_t Used(void) const;
+    size_t ObjectSize(void) const;
+    const void* Ptr(void) const;
+    size_t Size(void) const;
+
+    unsigned int next;  //!< one more than the index of the next slab on the same list, 0 at the end of the list
+    unsigned int prev;  //!< one more than the index of the slab before this one on its list, 0 at the head
+    unsigned int page;  //!< one more than the index of the page of blocks made from this slab's memory, 0 if it was never one
+    bool lent;          //!< true while the slab's memory is that page of blocks
+    bool purged;        //!< true while the system has been told it can take the empty slab back
+    uint64_t idleSince; //!< the time in milliseconds the slab last became empty
+
+  private:
+
+    char* mPtr;           //!< the start of the slab page
+    char* mCursor;        //!< the first object that has never been handed out
+    char* mEnd;           //!< the end of the last whole object in the page
+    void* mFree;          //!< objects given back, linked through their first bytes
+    uint32_t mSize;       //!< the size of the whole page in bytes
+    uint32_t mObjectSize; //!< the size class of every object in the slab
+    uint32_t mUsed;       //!< the number of objects handed out and not yet given back
+};
@@ -0,0 +1,414 @@
+/*!****************************************************************************
+\file     MemoryTrace.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Holds the implementation of all MemoryTrace class functions. Nothing here
+  allocates, so records can be written from inside operator new
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryTrace.h"
+#include <chrono>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+const size_t TRACE_BUFFER_BYTES = TRACE_BUFFER_RECORDS * sizeof(MemoryTraceRecord); //!< the bytes of the file in a single run
+
+static_assert(sizeof(MemoryTraceRecord) == 24, "the replay tool reads records of a fixed size");
+static_assert(sizeof(MemoryTraceHeader) % alignof(MemoryTraceRecord) == 0, "the first record has to be aligned");
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+//! The run of records the calling thread is filling, plain data so it needs
+//! no constructor that could run inside an allocation
+struct TraceBuffer
+{
+  MemoryTraceRecord* cursor;  //!< the next record to write
+  MemoryTraceRecord* end;     //!< the end of the run
+  uint32_t session;           //!< the trace the run belongs to, 0 before the thread first records
+  uint16_t thread;            //!< the number of the thread in that trace
+};
+
+//-----------------------------------------------------------------------------
+// Private Variables
+//-----------------------------------------------------------------------------
+
+static thread_local TraceBuffer traceBuffer;  //!< the run of the calling thread
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Class: MemoryTrace
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Finishes a running trace when the program exits. Other threads may still
+  be recording, so the file is finished but stays mapped until the process
+  is gone
+******************************************************************************/
+MemoryTrace::~MemoryTrace(void)
+{
+  // if no trace is running
+  if (mMapping == NULL)
+  {
+    return;
+  }
+
+  CloseFile(Finish());
+}
+
+/*!****************************************************************************
+\brief
+  Creates the trace file and starts recording into it, a trace that is
+  already running is stopped first
+
+\param path
+  the file to write, replaced if it exists
+
+\param size
+  the most bytes the file can grow to, records past it are counted as dropped
+
+\return
+  true if recording started, false if the file could not be created
+******************************************************************************/
+bool MemoryTrace::Start(const char* path, size_t size)
+{
+  Stop();
+
+  size_t runs = (size - sizeof(MemoryTraceHeader)) / TRACE_BUFFER_BYTES;
+
+  // if not even a single run fits
+  if (size < sizeof(MemoryTraceHeader) + TRACE_BUFFER_BYTES)
+  {
+    runs = 1;
+  }
+
+  size = sizeof(MemoryTraceHeader) + runs * TRACE_BUFFER_BYTES;
+
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  // if the file could not be created
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)(size) >> 32), (DWORD)(size), NULL);
+  void* memory = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : NULL;
+
+  // if the mapping is open, the view keeps it alive
+  if (mapping)
+  {
+    CloseHandle(mapping);
+  }
+
+  // if the file could not be mapped
+  if (memory == NULL)
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  mFile = (intptr_t)(file);
+#else
+  // a process still tracing to the old file, a parent that exec'd this one
+  // with the same MEMORY_TRACE, keeps writing to it instead of having it cut
+  // down under its mapping
+  unlink(path);
+
+  int file = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  // if the file could not be created
+  if (file < 0)
+  {
+    return false;
+  }
+
+  // the file is sparse, only runs that are written take up disk
+  void* memory = ftruncate(file, (off_t)(size)) == 0 ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+
+  // if the file could not be mapped
+  if (memory == MAP_FAILED)
+  {
+    close(file);
+    unlink(path);
+    return false;
+  }
+
+  mFile = file;
+#endif
+
+  mMapping = (char*)(memory);
+  mSize = size;
+  mStart = Now();
+  mThreads.store(0, std::memory_order_relaxed);
+  mCursor.store(sizeof(MemoryTraceHeader), std::memory_order_relaxed);
+  mDropped.store(0, std::memory_order_relaxed);
+  mSession.fetch_add(1, std::memory_order_release);  // every thread claims a new run on its next record
+  mEnabled.store(true, std::memory_order_release);
+
+  return true;
+}
+
+/*!****************************************************************************
+\brief
+  Stops recording, writes the header and cuts the file down to the runs that
+  were claimed. No other thread may be allocating while the trace stops, a
+  record being written would land in memory that is no longer mapped
+******************************************************************************/
+void MemoryTrace::Stop(void)
+{
+  // if no trace is running
+  if (mMapping == NULL)
+  {
+    return;
+  }
+
+  size_t used = Finish();
+
+#if defined(_WIN32)
+  UnmapViewOfFile(mMapping);  // the file can only be cut down once no view is open
+#else
+  munmap(mMapping, mSize);
+#endif
+
+  CloseFile(used);
+
+  mMapping = NULL;
+  mSize = 0;
+}
+
+/*!****************************************************************************
+\brief
+  Stops recording in the child of a fork without touching the file. The
+  mapping is shared with the parent, which keeps recording into it and
+  finishes the file, so the child only forgets about it
+******************************************************************************/
+void MemoryTrace::Detach(void)
+{
+  // if no trace is running
+  if (mMapping == NULL)
+  {
+    return;
+  }
+
+  mEnabled.store(false, std::memory_order_relaxed);
+
+#if !defined(_WIN32)
+  close((int)(mFile));  // only the child's copy of the descriptor
+#endif
+
+  mMapping = NULL;
+  mSize = 0;
+  mFile = -1;
+}
+
+/*!****************************************************************************
+\brief
+  Writes a record to the calling thread's run, claiming a new run when it is
+  full. Only call it while Enabled returns true
+
+\param op
+  what happened to the block
+
+\param size
+  the bytes asked for, 0 if they are not known
+
+\param ptr
+  the block
+******************************************************************************/
+void MemoryTrace::Record(MemoryTraceOp op, size_t size, const void* ptr)
+{
+  TraceBuffer& buffer = traceBuffer;
+
+  // if the run is full or belongs to an older trace
+  if (buffer.cursor == buffer.end || buffer.session != mSession.load(std::memory_order_relaxed))
+  {
+    // if the file is full
+    if (!ClaimBuffer())
+    {
+      mDropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  MemoryTraceRecord* record = buffer.cursor++;
+
+  record->time = Now() - mStart;
+  record->id = (uint64_t)(uintptr_t)(ptr);
+  record->size = size > UINT32_MAX ? UINT32_MAX : (uint32_t)(size);
+  record->thread = buffer.thread;
+  record->op = (uint8_t)(op);
+  record->reserved = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Private Class Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Stops recording and writes the header. The rest of the file is closed to
+  new runs, so a thread still recording can only finish a run it claimed
+
+\return
+  the bytes of the file in use, the header and every claimed run
+******************************************************************************/
+size_t MemoryTrace::Finish(void)
+{
+  mEnabled.store(false, std::memory_order_relaxed);
+
+  size_t used = mCursor.exchange(mSize, std::memory_order_relaxed);
+
+  // if threads tried to claim runs past the end of the file
+  if (used > mSize)
+  {
+    used = mSize;
+  }
+
+  const MemoryTraceRecord* records = (const MemoryTraceRecord*)(mMapping + sizeof(MemoryTraceHeader));
+  size_t count = (used - sizeof(MemoryTraceHeader)) / sizeof(MemoryTraceRecord);
+  uint64_t written = 0;
+
+  // for all records in the claimed runs
+  for (size_t i = 0; i < count; ++i)
+  {
+    written += records[i].op != MEMORY_TRACE_NONE;
+  }
+
+  MemoryTraceHeader* header = (MemoryTraceHeader*)(mMapping);
+
+  memcpy(header->magic, "MMTRACE", sizeof(header->magic));
+  header->version = TRACE_VERSION;
+  header->recordSize = sizeof(MemoryTraceRecord);
+  header->records = written;
+  header->dropped = mDropped.load(std::memory_order_relaxed);
+
+  return used;
+}
+
+/*!****************************************************************************
+\brief
+  Cuts the file down to the part in use and closes it. Runs that were never
+  claimed are cut off even while the file is still mapped, nothing writes
+  to them any more
+
+\param used
+  the bytes of the file to keep
+******************************************************************************/
+void MemoryTrace::CloseFile(size_t used)
+{
+#if defined(_WIN32)
+  HANDLE file = (HANDLE)(mFile);
+  LARGE_INTEGER end;
+
+  end.QuadPart = (LONGLONG)(used);
+
+  // if the file is still mapped the end can not move, the unused runs stay
+  // in the file, they read back as op 0 and are skipped
+  SetFilePointerEx(file, end, NULL, FILE_BEGIN);
+  SetEndOfFile(file);
+  CloseHandle(file);
+#else
+  // if the file could not be cut down
+  if (ftruncate((int)(mFile), (off_t)(used)) != 0)
+  {
+    // the unused runs stay in the file, they read back as op 0 and are skipped
+  }
+
+  close((int)(mFile));
+#endif
+
+  mFile = -1;
+}
+
+/*!****************************************************************************
+\brief
+  Claims the next unused run of the file for the calling thread, a thread
+  that has not recorded in this trace yet is given a number first
+
+\return
+  true if a run was claimed, false if the file is full
+******************************************************************************/
+bool MemoryTrace::ClaimBuffer(void)
+{
+  TraceBuffer& buffer = traceBuffer;
+  uint32_t session = mSession.load(std::memory_order_acquire);
+
+  // if the thread has not recorded in this trace yet
+  if (buffer.session != session)
+  {
+    buffer.session = session;
+    buffer.thread = (uint16_t)(mThreads.fetch_add(1, std::memory_order_relaxed));
+    buffer.cursor = NULL;
+    buffer.end = NULL;
+  }
+
+  size_t offset = mCursor.fetch_add(TRACE_BUFFER_BYTES, std::memory_order_relaxed);
+
+  // if the run would not fit in the file
+  if (offset + TRACE_BUFFER_BYTES > mSize)
+  {
+    return false;
+  }
+
+  buffer.cursor = (MemoryTraceRecord*)(mMapping + offset);
+  buffer.end = buffer.cursor + TRACE_BUFFER_RECORDS;
+
+  return true;
+}
+
+/*!****************************************************************************
+\brief
+  Reads the clock records are stamped with, it only ever moves forward
+
+\return
+  the time in nanoseconds
+******************************************************************************/
+uint64_t MemoryTrace::Now(void)
+{
+  return (uint64_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
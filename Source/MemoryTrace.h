@@ -0,0 +1,117 @@
+/*!****************************************************************************
+\file     MemoryTrace.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Declares the MemoryTrace class, which records every allocation and free to
+  a memory mapped file so the workload can be replayed later
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t TRACE_BUFFER_RECORDS = 2048;   //!< the records a thread claims room for at once, about 48 KB of the file
+const uint32_t TRACE_VERSION = 1;           //!< changed whenever the layout of the file changes
+
+//! What a trace record describes
+enum MemoryTraceOp
+{
+  MEMORY_TRACE_NONE,    //!< an unused record at the end of a thread's buffer
+  MEMORY_TRACE_ALLOC,   //!< a block was handed out
+  MEMORY_TRACE_FREE     //!< a block was given back
+};
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! The start of a trace file, followed by records up to the end of the file.
+//! Every thread fills runs of TRACE_BUFFER_RECORDS records, a run a thread
+//! did not fill before the trace stopped ends in records with op 0
+struct MemoryTraceHeader
+{
+  char magic[8];        //!< "MMTRACE" and a terminator
+  uint32_t version;     //!< TRACE_VERSION
+  uint32_t recordSize;  //!< sizeof(MemoryTraceRecord)
+  uint64_t records;     //!< the records written, not counting unused ones
+  uint64_t dropped;     //!< the records lost because the file was full
+};
+
+//! A single allocation or free. The records of one thread are in time order,
+//! the runs of records of different threads interleave in the file
+struct MemoryTraceRecord
+{
+  uint64_t time;    //!< nanoseconds since the trace started
+  uint64_t id;      //!< the address of the block, reused once the block is freed
+  uint32_t size;    //!< the bytes asked for, 0 for a free of unknown size
+  uint16_t thread;  //!< the thread, numbered in the order threads first recorded
+  uint8_t op;       //!< a MemoryTraceOp
+  uint8_t reserved; //!< always 0
+};
+
+//! Writes records into a file mapped into memory. Every thread claims a
+//! buffer of the file at a time and fills it without locking, so recording
+//! costs a clock read and a few stores. The file is created at its full size
+//! and cut down to the part that was claimed when the trace stops
+class MemoryTrace
+{
+  public:
+
+    constexpr MemoryTrace(void) : mEnabled(false), mSession(0), mThreads(0), mCursor(0), mDropped(0),
+                                  mMapping(NULL), mSize(0), mStart(0), mFile(-1) {}
+    ~MemoryTrace(void);
+
+    bool Start(const char* path, size_t size);
+    void Stop(void);
+    void Detach(void);
+
+    //! Checks whether allocations are being recorded, a single relaxed load
+    //! so the check costs nothing noticeable while tracing is off
+    bool Enabled(void) const { return mEnabled.load(std::memory_order_relaxed); }
+
+    void Record(MemoryTraceOp op, size_t size, const void* ptr);
+
+  private:
+
+    std::atomic<bool> mEnabled;       //!< true while records are written
+    std::atomic<uint32_t> mSession;   //!< changed on every Start so threads drop buffers of an older file
+    std::atomic<uint32_t> mThreads;   //!< the number of threads that have recorded
+    std::atomic<size_t> mCursor;      //!< the offset of the first buffer of the file not claimed yet
+    std::atomic<uint64_t> mDropped;   //!< the records lost because the file was full
+    char* mMapping;                   //!< the whole file in memory
+    size_t mSize;                     //!< the size the file was created at
+    uint64_t mStart;                  //!< the clock reading in nanoseconds when the trace started
+    intptr_t mFile;                   //!< the open file, a descriptor or a handle, -1 while there is none
+
+    size_t Finish(void);
+    void CloseFile(size_t used);
+    bool ClaimBuffer(void);
+    static uint64_t Now(void);
+};
@@ -0,0 +1,378 @@
+/*!****************************************************************************
+\file     ObjectPool.h
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  A pool of objects of a single type carved from slabs of pages mapped by the
+  manager's page source, for types that are created and destroyed at a high
+  rate
+
+******************************************************************************/
+
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "MemoryManager.h"
+#include <stddef.h>
+#include <mutex>
+#include <new>
+#include <utility>
+
+//-----------------------------------------------------------------------------
+// Forward References
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Consts
+//-----------------------------------------------------------------------------
+
+const size_t OBJECT_POOL_SLAB_SIZE = 64 * 1024; //!< the default number of bytes mapped for each slab of a pool
+const size_t OBJECT_POOL_CACHE_SIZE = 64;       //!< the most objects a front cache holds before half go back to the pool
+
+//-----------------------------------------------------------------------------
+// Public Variables
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Public Classes
+//-----------------------------------------------------------------------------
+
+//! Hands out objects of type T from slabs of SLAB_SIZE bytes. Dead objects
+//! keep the free list in their own memory, so the pool spends nothing per
+//! object beyond sizeof(T). The pool is safe to share between threads, a
+//! thread that creates many objects can put a Cache in front of it to skip
+//! the lock. Slabs go back to the system when the pool is destroyed
+template <class T, size_t SLAB_SIZE = OBJECT_POOL_SLAB_SIZE>
+class ObjectPool
+{
+  //! The memory of one object, it holds the free list link while the object
+  //! is dead
+  union Slot
+  {
+    Slot* next;                                   //!< the next dead object
+    alignas(T) unsigned char object[sizeof(T)];   //!< the memory of a live object
+  };
+
+  //! The start of every slab, links the slabs so they can be unmapped
+  struct Slab
+  {
+    Slab* next; //!< the slab mapped before this one
+  };
+
+  static const size_t FIRST_SLOT = (sizeof(Slab) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot); //!< the offset of the first object in a slab
+
+  static_assert(SLAB_SIZE >= FIRST_SLOT + sizeof(Slot), "a slab must hold at least one object");
+  static_assert(alignof(Slot) <= 4096, "objects can not be aligned past the system page size");
+
+public:
+
+  //! A front cache used by a single thread, objects are created from and
+  //! destroyed into it without locking. It trades objects with the pool half
+  //! a cache at a time and gives back all it holds when it is destroyed
+  class Cache
+  {
+  public:
+
+    Cache(ObjectPool& pool) : mPool(pool), mFree(NULL), mCount(0) {}
+
+    ~Cache(void)
+    {
+      // if the cache holds any objects
+      if (mFree)
+      {
+        Slot* last = mFree;
+
+        // while the end of the list has not been found
+        while (last->next)
+        {
+          last = last->next;
+        }
+
+        mPool.GiveBack(mFree, last);
+      }
+    }
+
+    Cache(const Cache& rhs) = delete;
+    Cache& operator=(const Cache& rhs) = delete;
+
+    /*!************************************************************************
+    \brief
+      Constructs an object from the cache, an empty cache first takes half a
+      cache worth of objects from the pool
+
+    \param args
+      the arguments forwarded to the constructor of T
+
+    \return
+      the new object
+    **************************************************************************/
+    template <class... Args>
+    T* Create(Args&&... args)
+    {
+      // if the cache is empty
+      if (mFree == NULL)
+      {
+        mCount = mPool.TakeBatch(mFree, OBJECT_POOL_CACHE_SIZE / 2);
+      }
+
+      Slot* slot = mFree;
+
+      mFree = slot->next;
+      --mCount;
+
+      try
+      {
+        return new(slot->object) T(std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        slot->next = mFree; // the slot was never used, put it back
+        mFree = slot;
+        ++mCount;
+        throw;
+      }
+    }
+
+    /*!************************************************************************
+    \brief
+      Destroys an object into the cache, a full cache sends half of its
+      objects back to the pool
+
+    \param object
+      an object from this cache's pool, NULL is ignored
+    **************************************************************************/
+    void Destroy(T* object)
+    {
+      // if there is no object
+      if (object == NULL)
+      {
+        return;
+      }
+
+      object->~T();
+
+      Slot* slot = reinterpret_cast<Slot*>(object);
+
+      slot->next = mFree;
+      mFree = slot;
+
+      // if the cache is holding too many objects
+      if (++mCount >= OBJECT_POOL_CACHE_SIZE)
+      {
+        Slot* first = mFree;
+        Slot* last = mFree;
+
+        // for the half of the objects being sent back
+        for (size_t i = 1; i < OBJECT_POOL_CACHE_SIZE / 2; ++i)
+        {
+          last = last->next;
+        }
+
+        mFree = last->next;
+        last->next = NULL;
+        mCount -= OBJECT_POOL_CACHE_SIZE / 2;
+
+        mPool.GiveBack(first, last);
+      }
+    }
+
+  private:
+
+    ObjectPool& mPool;  //!< the pool objects are traded with
+    Slot* mFree;        //!< the dead objects held by the cache
+    size_t mCount;      //!< the number of objects in mFree
+  };
+
+  ObjectPool(void) : mFree(NULL), mCursor(NULL), mEnd(NULL), mSlabs(NULL) {}
+
+  /*!**************************************************************************
+  \brief
+    Unmaps every slab, objects still alive are not destroyed
+  ****************************************************************************/
+  ~ObjectPool(void)
+  {
+    // while there are slabs left
+    while (mSlabs)
+    {
+      Slab* next = mSlabs->next;
+
+      MemoryManagerUnmapPages(mSlabs, SLAB_SIZE);
+      mSlabs = next;
+    }
+  }
+
+  ObjectPool(const ObjectPool& rhs) = delete;
+  ObjectPool& operator=(const ObjectPool& rhs) = delete;
+
+  /*!**************************************************************************
+  \brief
+    Constructs an object in the pool
+
+  \param args
+    the arguments forwarded to the constructor of T
+
+  \return
+    the new object
+  ****************************************************************************/
+  template <class... Args>
+  T* Create(Args&&... args)
+  {
+    Slot* slot;
+
+    TakeBatch(slot, 1);
+
+    try
+    {
+      return new(slot->object) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      GiveBack(slot, slot); // the slot was never used, put it back
+      throw;
+    }
+  }
+
+  /*!**************************************************************************
+  \brief
+    Destroys an object and gives its memory back to the pool
+
+  \param object
+    an object from this pool, NULL is ignored
+  ****************************************************************************/
+  void Destroy(T* object)
+  {
+    // if there is no object
+    if (object == NULL)
+    {
+      return;
+    }
+
+    object->~T();
+
+    Slot* slot = reinterpret_cast<Slot*>(object);
+
+    GiveBack(slot, slot);
+  }
+
+private:
+
+  std::mutex mLock; //!< held while the free list or slabs are being changed
+  Slot* mFree;      //!< dead objects, linked through their memory
+  char* mCursor;    //!< the first object in the newest slab that was never handed out
+  char* mEnd;       //!< the end of the last whole object in the newest slab
+  Slab* mSlabs;     //!< every slab, newest first
+
+  /*!**************************************************************************
+  \brief
+    Takes a number of slots from the pool under a single lock, dead objects
+    are used first and then the untouched end of the newest slab. A new slab
+    is mapped when both run out. If it can not be mapped fewer slots are
+    taken, and with none taken throws bad_alloc
+
+  \param first
+    set to the first slot, the slots are linked through next
+
+  \param count
+    the number of slots to take, at least 1
+
+  \return
+    the number of slots taken
+  ****************************************************************************/
+  size_t TakeBatch(Slot*& first, size_t count)
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    Slot* list = NULL;
+
+    // for all slots being taken
+    for (size_t i = 0; i < count; ++i)
+    {
+      Slot* slot = mFree;
+
+      // if there is a dead object
+      if (slot)
+      {
+        mFree = slot->next;
+      }
+      else
+      {
+        // if the newest slab is used up and no new one can be mapped
+        if (mCursor == mEnd && !AllocateSlab())
+        {
+          // if no slot was taken
+          if (list == NULL)
+          {
+            throw std::bad_alloc();
+          }
+
+          count = i;
+          break;
+        }
+
+        slot = reinterpret_cast<Slot*>(mCursor);
+        mCursor += sizeof(Slot);
+      }
+
+      slot->next = list;
+      list = slot;
+    }
+
+    first = list;
+
+    return count;
+  }
+
+  /*!**************************************************************************
+  \brief
+    Gives a list of dead objects back to the pool under a single lock
+
+  \param first
+    the first slot of the list
+
+  \param last
+    the last slot of the list, every slot before it links to the next
+  ****************************************************************************/
+  void GiveBack(Slot* first, Slot* last)
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    last->next = mFree;
+    mFree = first;
+  }
+
+  /*!**************************************************************************
+  \brief
+    Maps a new slab and makes it the one objects are carved from, the lock
+    must already be held
+
+  \return
+    true if the slab was mapped, false if the system is out of memory
+  ****************************************************************************/
+  bool AllocateSlab(void)
+  {
+    Slab* slab = static_cast<Slab*>(MemoryManagerMapPages(SLAB_SIZE));
+
+    // if the system is out of memory
+    if (slab == NULL)
+    {
+      return false;
+    }
+
+    slab->next = mSlabs;
+    mSlabs = slab;
+
+    mCursor = reinterpret_cast<char*>(slab) + FIRST_SLOT;
+    mEnd = mCursor + (SLAB_SIZE - FIRST_SLOT) / sizeof(Slot) * sizeof(Slot);
+
+    return true;
+  }
+};
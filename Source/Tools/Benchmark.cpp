@@ -0,0 +1,934 @@
+/*!****************************************************************************
+\file     Benchmark.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Runs the standard allocator workloads against the manager and against the
+  system malloc and prints the results as text, JSON or CSV so they can be
+  compared between builds
+
+  Usage: Benchmark [--format text | json | csv] [--threads N] [--scale X]
+                   [--allocator manager | malloc] [workload ...]
+
+  The workloads are random, larson, producer-consumer, list-churn and
+  scaling. All of them run when none are named
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "../MemoryManager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+const size_t RANDOM_SLOTS = 1000;       //!< the blocks every thread of the random workload keeps alive
+
+const size_t LARSON_SLOTS = 1000;       //!< the blocks every thread of the larson workload keeps alive
+
+const unsigned int LARSON_ROUNDS = 10;  //!< the threads that take over each set of larson blocks one after another
+
+const size_t RING_SIZE = 1024;          //!< the messages that fit between a producer and its consumer
+
+const size_t LIST_NODES = 10000;        //!< the nodes in every thread's list
+
+const unsigned int RSS_INTERVAL = 1;    //!< the milliseconds between samples of the resident memory
+
+//! How the results are printed
+enum BenchFormat
+{
+  BENCH_TEXT, //!< a line per result for people
+  BENCH_JSON, //!< a single JSON array with an object per result
+  BENCH_CSV   //!< a header line and a line per result
+};
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+//! The functions an allocator is measured with
+struct BenchAllocator
+{
+  const char* name;               //!< the name results are printed under
+  void* (*allocate)(size_t size); //!< allocates a block
+  void (*destroy)(void* ptr);     //!< frees a block
+};
+
+//! A workload, it starts its own threads and returns the blocks it allocated
+struct BenchWorkload
+{
+  const char* name;                                                            //!< the name results are printed under
+  size_t (*run)(const BenchAllocator& allocator, unsigned int threads, size_t operations);  //!< runs the workload once
+  size_t operations;                                                           //!< the blocks every thread allocates at scale 1
+};
+
+//! What one run of a workload measured
+struct BenchResult
+{
+  size_t allocations; //!< the blocks allocated and freed over all threads
+  double seconds;     //!< the time the workload took
+  size_t peakRSS;     //!< the most memory in kilobytes that was resident on top of what was before the run
+};
+
+//! Settings read from the command line
+struct BenchOptions
+{
+  BenchFormat format = BENCH_TEXT;  //!< how results are printed
+  unsigned int threads = 0;         //!< the threads every workload but scaling uses
+  double scale = 1.0;               //!< multiplies the operations of every workload
+  const char* allocator = NULL;     //!< the only allocator to measure, NULL for both
+  std::vector<const char*> workloads; //!< the only workloads to run, empty for all
+};
+
+//! One node of a list-churn list, the payload of the node follows it
+struct ListNode
+{
+  ListNode* prev;   //!< the node before this one
+  ListNode* next;   //!< the node after this one
+  size_t value;     //!< read on every walk so the walk touches the node
+};
+
+//-----------------------------------------------------------------------------
+// Private Function Declerations
+//-----------------------------------------------------------------------------
+
+size_t RandomRun(const BenchAllocator& allocator, unsigned int threads, size_t operations);
+void RandomWork(const BenchAllocator& allocator, unsigned int seed, size_t operations);
+size_t LarsonRun(const BenchAllocator& allocator, unsigned int threads, size_t operations);
+void LarsonWork(const BenchAllocator& allocator, std::vector<void*>& slots, unsigned int seed, size_t operations);
+size_t ProducerConsumerRun(const BenchAllocator& allocator, unsigned int threads, size_t operations);
+size_t ListChurnRun(const BenchAllocator& allocator, unsigned int threads, size_t operations);
+void ListChurnWork(const BenchAllocator& allocator, unsigned int seed, size_t operations);
+BenchResult Measure(const BenchWorkload& workload, const BenchAllocator& allocator, unsigned int threads, size_t operations);
+BenchResult MeasureIsolated(const BenchWorkload& workload, const BenchAllocator& allocator, unsigned int threads, size_t operations);
+void PrintResult(const BenchOptions& options, const char* workload, const char* allocator, unsigned int threads,
+                 const BenchResult& result, bool first);
+bool ReadOptions(int argc, char** argv, BenchOptions& options);
+bool Selected(const BenchOptions& options, const char* workload);
+size_t CurrentRSS(void);
+
+//-----------------------------------------------------------------------------
+// Private Variables
+//-----------------------------------------------------------------------------
+
+std::atomic<size_t> checksum(0); //!< values read by the workloads, kept so the reads are not optimized away
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  BenchOptions options;
+
+  // if the command line could not be read
+  if (!ReadOptions(argc, argv, options))
+  {
+    fprintf(stderr, "Usage: %s [--format text | json | csv] [--threads N] [--scale X] [--allocator manager | malloc] "
+                    "[random | larson | producer-consumer | list-churn | scaling ...]\n", argv[0]);
+    return 1;
+  }
+
+  const BenchAllocator allocators[] = { { "manager", Alloc, Delete }, { "malloc", malloc, free } };
+  const BenchWorkload workloads[] = { { "random", RandomRun, 1000000 },
+                                      { "larson", LarsonRun, 1000000 },
+                                      { "producer-consumer", ProducerConsumerRun, 1000000 },
+                                      { "list-churn", ListChurnRun, 1000000 } };
+  const BenchWorkload scaling = { "scaling", RandomRun, 500000 };
+  unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+  unsigned int threads = options.threads ? options.threads : std::max(cores, 2u);  // at least a pair for cross-thread frees
+  bool first = true;
+
+  // if results are printed as CSV
+  if (options.format == BENCH_CSV)
+  {
+    printf("workload,allocator,threads,allocations,seconds,allocations_per_second,peak_rss_kb\n");
+  }
+  // if results are printed as JSON
+  else if (options.format == BENCH_JSON)
+  {
+    printf("[\n");
+  }
+
+  // for all workloads
+  for (const BenchWorkload& workload : workloads)
+  {
+    // for all allocators
+    for (const BenchAllocator& allocator : allocators)
+    {
+      // if the workload or allocator was not asked for
+      if (!Selected(options, workload.name) || (options.allocator && strcmp(options.allocator, allocator.name) != 0))
+      {
+        continue;
+      }
+
+      BenchResult result = MeasureIsolated(workload, allocator, threads, (size_t)(workload.operations * options.scale));
+
+      PrintResult(options, workload.name, allocator.name, threads, result, first);
+      first = false;
+    }
+  }
+
+  // for all thread counts up to twice the cores, doubling each time
+  for (unsigned int count = 1; count <= std::max(2 * cores, 4u) && Selected(options, scaling.name); count *= 2)
+  {
+    // for all allocators
+    for (const BenchAllocator& allocator : allocators)
+    {
+      // if the allocator was not asked for
+      if (options.allocator && strcmp(options.allocator, allocator.name) != 0)
+      {
+        continue;
+      }
+
+      BenchResult result = MeasureIsolated(scaling, allocator, count, (size_t)(scaling.operations * options.scale));
+
+      PrintResult(options, scaling.name, allocator.name, count, result, first);
+      first = false;
+    }
+  }
+
+  // if results are printed as JSON
+  if (options.format == BENCH_JSON)
+  {
+    printf("\n]\n");
+  }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Every thread replaces randomly chosen blocks of a set it keeps alive with
+  blocks of random sizes, from a few bytes up to past the large threshold
+  with small sizes the most common
+
+\param allocator
+  the allocator to measure
+
+\param threads
+  the number of threads
+
+\param operations
+  the blocks every thread allocates
+
+\return
+  the blocks allocated over all threads
+******************************************************************************/
+size_t RandomRun(const BenchAllocator& allocator, unsigned int threads, size_t operations)
+{
+  std::vector<std::thread> workers;
+
+  // start every thread
+  for (unsigned int i = 0; i < threads; ++i)
+  {
+    workers.emplace_back(RandomWork, std::cref(allocator), i + 1, operations);
+  }
+
+  // wait for every thread
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+
+  return threads * operations;
+}
+
+/*!****************************************************************************
+\brief
+  The work of one random thread. Sizes are 2 to the power of a uniform
+  exponent, so every power of two from 8 bytes to 512 KiB is as likely
+
+\param allocator
+  the allocator to measure
+
+\param seed
+  the seed for the thread's sizes and slots
+
+\param operations
+  the number of blocks to allocate and free
+******************************************************************************/
+void RandomWork(const BenchAllocator& allocator, unsigned int seed, size_t operations)
+{
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<size_t> exponent(3, 18);
+  std::uniform_int_distribution<size_t> slot(0, RANDOM_SLOTS - 1);
+  std::vector<void*> slots(RANDOM_SLOTS, NULL);
+
+  // for all operations
+  for (size_t i = 0; i < operations; ++i)
+  {
+    size_t index = slot(random);
+    size_t power = (size_t)(1) << exponent(random);
+    size_t size = power + (random() & (power - 1));
+
+    // if the slot holds a block
+    if (slots[index])
+    {
+      allocator.destroy(slots[index]);
+    }
+
+    slots[index] = allocator.allocate(size);
+    *(char*)(slots[index]) = (char)(i);
+  }
+
+  // for all slots
+  for (void* block : slots)
+  {
+    // if the slot holds a block
+    if (block)
+    {
+      allocator.destroy(block);
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  The larson server workload. Every set of blocks is worked on by a thread
+  that replaces random blocks for a while and exits, then a new thread takes
+  the set over, so most blocks are freed by a thread other than the one that
+  allocated them and threads keep coming and going
+
+\param allocator
+  the allocator to measure
+
+\param threads
+  the number of sets of blocks, each worked on by one thread at a time
+
+\param operations
+  the blocks allocated for each set over all of its threads
+
+\return
+  the blocks allocated over all threads
+******************************************************************************/
+size_t LarsonRun(const BenchAllocator& allocator, unsigned int threads, size_t operations)
+{
+  std::vector<std::vector<void*>> sets(threads, std::vector<void*>(LARSON_SLOTS, NULL));
+  std::vector<std::thread> owners;
+
+  // for all sets of blocks
+  for (unsigned int i = 0; i < threads; ++i)
+  {
+    owners.emplace_back([&allocator, &sets, i, operations]()
+    {
+      // for all rounds, each on a new thread
+      for (unsigned int round = 0; round < LARSON_ROUNDS; ++round)
+      {
+        std::thread worker(LarsonWork, std::cref(allocator), std::ref(sets[i]), i * LARSON_ROUNDS + round + 1,
+                           operations / LARSON_ROUNDS);
+
+        worker.join();
+      }
+    });
+  }
+
+  // wait for every set to finish its rounds
+  for (std::thread& owner : owners)
+  {
+    owner.join();
+  }
+
+  // for all sets of blocks
+  for (std::vector<void*>& slots : sets)
+  {
+    // for all slots
+    for (void* block : slots)
+    {
+      // if the slot holds a block
+      if (block)
+      {
+        allocator.destroy(block);
+      }
+    }
+  }
+
+  return threads * (operations / LARSON_ROUNDS) * LARSON_ROUNDS;
+}
+
+/*!****************************************************************************
+\brief
+  One round of a larson set, small blocks of random sizes replace random
+  blocks of the set
+
+\param allocator
+  the allocator to measure
+
+\param slots
+  the set of blocks, some of them allocated by the threads of earlier rounds
+
+\param seed
+  the seed for the round's sizes and slots
+
+\param operations
+  the number of blocks to allocate
+******************************************************************************/
+void LarsonWork(const BenchAllocator& allocator, std::vector<void*>& slots, unsigned int seed, size_t operations)
+{
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<size_t> size(16, 512);
+  std::uniform_int_distribution<size_t> slot(0, slots.size() - 1);
+
+  // for all operations
+  for (size_t i = 0; i < operations; ++i)
+  {
+    size_t index = slot(random);
+
+    // if the slot holds a block
+    if (slots[index])
+    {
+      allocator.destroy(slots[index]);
+    }
+
+    slots[index] = allocator.allocate(size(random));
+    *(char*)(slots[index]) = (char)(i);
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Pairs of threads pass messages through a ring, the producer allocates and
+  fills every message and the consumer reads and frees it, so every free is
+  of a block another thread allocated
+
+\param allocator
+  the allocator to measure
+
+\param threads
+  the number of threads, one pair for every two
+
+\param operations
+  the messages every pair passes
+
+\return
+  the messages passed over all pairs
+******************************************************************************/
+size_t ProducerConsumerRun(const BenchAllocator& allocator, unsigned int threads, size_t operations)
+{
+  unsigned int pairs = std::max(threads / 2, 1u);
+  std::vector<std::atomic<void*>> rings(pairs * RING_SIZE);
+  std::vector<std::thread> workers;
+
+  // for all pairs
+  for (unsigned int i = 0; i < pairs; ++i)
+  {
+    std::atomic<void*>* ring = rings.data() + i * RING_SIZE;
+
+    workers.emplace_back([&allocator, ring, i, operations]()
+    {
+      std::mt19937 random(i + 1);
+      std::uniform_int_distribution<size_t> size(32, 512);
+
+      // for all messages
+      for (size_t j = 0; j < operations; ++j)
+      {
+        size_t messageSize = size(random);
+        char* message = (char*)(allocator.allocate(messageSize));
+        std::atomic<void*>& slot = ring[j % RING_SIZE];
+
+        memset(message, (int)(j & 0xFF), messageSize);
+
+        // while the consumer has not emptied the slot
+        while (slot.load(std::memory_order_acquire))
+        {
+          std::this_thread::yield();
+        }
+
+        slot.store(message, std::memory_order_release);
+      }
+    });
+
+    workers.emplace_back([&allocator, ring, operations]()
+    {
+      size_t sum = 0;
+
+      // for all messages
+      for (size_t j = 0; j < operations; ++j)
+      {
+        std::atomic<void*>& slot = ring[j % RING_SIZE];
+        void* message;
+
+        // while the producer has not filled the slot
+        while ((message = slot.load(std::memory_order_acquire)) == NULL)
+        {
+          std::this_thread::yield();
+        }
+
+        slot.store(NULL, std::memory_order_release);
+        sum += *(unsigned char*)(message);
+        allocator.destroy(message);
+      }
+
+      checksum += sum;
+    });
+  }
+
+  // wait for every thread
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+
+  return pairs * operations;
+}
+
+/*!****************************************************************************
+\brief
+  Every thread keeps a long linked list of nodes with payloads of random
+  sizes, walks a few nodes at a time and replaces the node it stops on, so
+  the list ends up spread over whatever memory the allocator handed out
+
+\param allocator
+  the allocator to measure
+
+\param threads
+  the number of threads, each with a list of its own
+
+\param operations
+  the nodes every thread replaces
+
+\return
+  the nodes allocated over all threads, not counting the first list
+******************************************************************************/
+size_t ListChurnRun(const BenchAllocator& allocator, unsigned int threads, size_t operations)
+{
+  std::vector<std::thread> workers;
+
+  // start every thread
+  for (unsigned int i = 0; i < threads; ++i)
+  {
+    workers.emplace_back(ListChurnWork, std::cref(allocator), i + 1, operations);
+  }
+
+  // wait for every thread
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+
+  return threads * operations;
+}
+
+/*!****************************************************************************
+\brief
+  The work of one list-churn thread
+
+\param allocator
+  the allocator to measure
+
+\param seed
+  the seed for the thread's payloads and walks
+
+\param operations
+  the number of nodes to replace
+******************************************************************************/
+void ListChurnWork(const BenchAllocator& allocator, unsigned int seed, size_t operations)
+{
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<size_t> payload(0, 96);
+  std::uniform_int_distribution<size_t> steps(1, 16);
+  ListNode* cursor = (ListNode*)(allocator.allocate(sizeof(ListNode)));
+  size_t sum = 0;
+
+  cursor->prev = cursor;
+  cursor->next = cursor;
+  cursor->value = 0;
+
+  // for all nodes after the first
+  for (size_t i = 1; i < LIST_NODES; ++i)
+  {
+    ListNode* node = (ListNode*)(allocator.allocate(sizeof(ListNode) + payload(random)));
+
+    node->value = i;
+    node->prev = cursor;
+    node->next = cursor->next;
+    cursor->next->prev = node;
+    cursor->next = node;
+  }
+
+  // for all operations
+  for (size_t i = 0; i < operations; ++i)
+  {
+    // for all nodes walked past
+    for (size_t step = steps(random); step > 0; --step)
+    {
+      sum += cursor->value;
+      cursor = cursor->next;
+    }
+
+    ListNode* node = (ListNode*)(allocator.allocate(sizeof(ListNode) + payload(random)));
+    ListNode* old = cursor;
+
+    node->value = i;
+    node->prev = old->prev;
+    node->next = old->next;
+    old->prev->next = node;
+    old->next->prev = node;
+    cursor = node;
+    allocator.destroy(old);
+  }
+
+  // for all nodes in the list
+  for (size_t i = 0; i < LIST_NODES; ++i)
+  {
+    ListNode* next = cursor->next;
+
+    allocator.destroy(cursor);
+    cursor = next;
+  }
+
+  checksum += sum;
+}
+
+/*!****************************************************************************
+\brief
+  Runs a workload once and measures it, a thread samples the resident memory
+  while it runs
+
+\param workload
+  the workload to run
+
+\param allocator
+  the allocator to measure
+
+\param threads
+  the number of threads the workload uses
+
+\param operations
+  the blocks every thread allocates
+
+\return
+  what was measured
+******************************************************************************/
+BenchResult Measure(const BenchWorkload& workload, const BenchAllocator& allocator, unsigned int threads, size_t operations)
+{
+  size_t startRSS = CurrentRSS();
+  std::atomic<size_t> peakRSS(startRSS);
+  std::atomic<bool> running(true);
+
+  std::thread sampler([&peakRSS, &running]()
+  {
+    // while the workload runs
+    while (running.load(std::memory_order_relaxed))
+    {
+      peakRSS = std::max(peakRSS.load(), CurrentRSS());
+      std::this_thread::sleep_for(std::chrono::milliseconds(RSS_INTERVAL));
+    }
+  });
+
+  BenchResult result;
+  auto startTime = std::chrono::steady_clock::now();
+
+  result.allocations = workload.run(allocator, threads, operations);
+
+  std::chrono::duration<double> diff = std::chrono::steady_clock::now() - startTime;
+
+  running = false;
+  sampler.join();
+
+  result.seconds = diff.count();
+  result.peakRSS = peakRSS.load() - startRSS;
+
+  return result;
+}
+
+/*!****************************************************************************
+\brief
+  Measures a workload. On Linux it runs in a child process so every run
+  starts with a fresh allocator and its peak memory is its own, elsewhere the
+  runs share one process
+
+\param workload
+  the workload to run
+
+\param allocator
+  the allocator to measure
+
+\param threads
+  the number of threads the workload uses
+
+\param operations
+  the blocks every thread allocates
+
+\return
+  what was measured, all 0 if the child failed
+******************************************************************************/
+BenchResult MeasureIsolated(const BenchWorkload& workload, const BenchAllocator& allocator, unsigned int threads, size_t operations)
+{
+  BenchResult result = {};
+
+#if defined(__linux__)
+  int pipes[2];
+
+  // if the child could not be given a pipe to report back through
+  if (pipe(pipes) != 0)
+  {
+    return Measure(workload, allocator, threads, operations);
+  }
+
+  fflush(stdout);
+
+  pid_t child = fork();
+
+  // if this is the child process
+  if (child == 0)
+  {
+    result = Measure(workload, allocator, threads, operations);
+
+    // if the parent could not be told, it reports the run as failed
+    if (write(pipes[1], &result, sizeof(result)) != sizeof(result))
+    {
+      _exit(1);
+    }
+
+    _exit(0);
+  }
+
+  close(pipes[1]);
+
+  // if the child was started
+  if (child > 0)
+  {
+    // if the child did not report, it crashed
+    if (read(pipes[0], &result, sizeof(result)) != sizeof(result))
+    {
+      result = BenchResult();
+    }
+
+    waitpid(child, NULL, 0);
+  }
+
+  close(pipes[0]);
+#else
+  result = Measure(workload, allocator, threads, operations);
+#endif
+
+  return result;
+}
+
+/*!****************************************************************************
+\brief
+  Prints the result of one run in the chosen format
+
+\param options
+  the format to print in
+
+\param workload
+  the name of the workload
+
+\param allocator
+  the name of the allocator
+
+\param threads
+  the number of threads the workload used
+
+\param result
+  what was measured
+
+\param first
+  true for the first result, JSON puts a comma in front of every other one
+******************************************************************************/
+void PrintResult(const BenchOptions& options, const char* workload, const char* allocator, unsigned int threads,
+                 const BenchResult& result, bool first)
+{
+  double rate = result.seconds > 0.0 ? result.allocations / result.seconds : 0.0;
+
+  switch (options.format)
+  {
+    case BENCH_JSON:
+      printf("%s  {\"workload\": \"%s\", \"allocator\": \"%s\", \"threads\": %u, \"allocations\": %zu, \"seconds\": %.6f, "
+             "\"allocations_per_second\": %.0f, \"peak_rss_kb\": %zu}", first ? "" : ",\n", workload, allocator, threads,
+             result.allocations, result.seconds, rate, result.peakRSS);
+      break;
+
+    case BENCH_CSV:
+      printf("%s,%s,%u,%zu,%.6f,%.0f,%zu\n", workload, allocator, threads, result.allocations, result.seconds, rate,
+             result.peakRSS);
+      break;
+
+    default:
+      printf("%-18s %-8s %3u threads %14.0f allocations/s %10zu KB peak RSS\n", workload, allocator, threads, rate,
+             result.peakRSS);
+      break;
+  }
+
+  fflush(stdout);
+}
+
+/*!****************************************************************************
+\brief
+  Reads the options from the command line
+
+\param argc
+  the number of arguments
+
+\param argv
+  the arguments
+
+\param options
+  filled with the options
+
+\return
+  true if every argument was understood, else false
+******************************************************************************/
+bool ReadOptions(int argc, char** argv, BenchOptions& options)
+{
+  // for all arguments
+  for (int i = 1; i < argc; ++i)
+  {
+    const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    // if the argument is an option that needs a value it does not have
+    if (argv[i][0] == '-' && value == NULL)
+    {
+      return false;
+    }
+
+    // if the output format is chosen
+    if (strcmp(argv[i], "--format") == 0)
+    {
+      // if the format is not known
+      if (strcmp(value, "text") != 0 && strcmp(value, "json") != 0 && strcmp(value, "csv") != 0)
+      {
+        return false;
+      }
+
+      options.format = value[0] == 'j' ? BENCH_JSON : value[0] == 'c' ? BENCH_CSV : BENCH_TEXT;
+      ++i;
+    }
+    // if the thread count is chosen
+    else if (strcmp(argv[i], "--threads") == 0)
+    {
+      options.threads = (unsigned int)(strtoul(value, NULL, 10));
+      ++i;
+    }
+    // if the amount of work is scaled
+    else if (strcmp(argv[i], "--scale") == 0)
+    {
+      options.scale = strtod(value, NULL);
+      ++i;
+    }
+    // if a single allocator is chosen
+    else if (strcmp(argv[i], "--allocator") == 0)
+    {
+      options.allocator = value;
+      ++i;
+    }
+    // if the argument is not an option
+    else if (argv[i][0] != '-')
+    {
+      options.workloads.push_back(argv[i]);
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  return options.scale > 0.0;
+}
+
+/*!****************************************************************************
+\brief
+  Checks whether a workload should run
+
+\param options
+  the workloads asked for
+
+\param workload
+  the name of the workload
+
+\return
+  true if the workload was named or none were, else false
+******************************************************************************/
+bool Selected(const BenchOptions& options, const char* workload)
+{
+  // if no workloads were named
+  if (options.workloads.empty())
+  {
+    return true;
+  }
+
+  // for all named workloads
+  for (const char* name : options.workloads)
+  {
+    // if the workload was named
+    if (strcmp(name, workload) == 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*!****************************************************************************
+\brief
+  Gets the memory the process has resident right now
+
+\return
+  the resident set size in kilobytes
+******************************************************************************/
+size_t CurrentRSS(void)
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+  return counters.WorkingSetSize / 1024;
+#elif defined(__linux__)
+  FILE* file = fopen("/proc/self/statm", "r");
+  size_t size = 0;
+  size_t resident = 0;
+
+  // if the process statistics could be read
+  if (file)
+  {
+    // if the numbers could not be read
+    if (fscanf(file, "%zu %zu", &size, &resident) != 2)
+    {
+      resident = 0;
+    }
+
+    fclose(file);
+  }
+
+  return resident * (size_t)(sysconf(_SC_PAGESIZE)) / 1024;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  return (size_t)(usage.ru_maxrss);
+#endif
+}
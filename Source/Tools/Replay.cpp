@@ -0,0 +1,571 @@
+/*!****************************************************************************
+\file     Replay.cpp
+\author   Kenny Mecham
+\par      Email: kennethmecham\@comcast.net
+\par      Project: Memory Manager
+\date     10-16-2026
+
+\brief
+  Replays a trace written by MemoryManagerTraceStart against the manager and
+  against the system malloc, and reports the throughput, the latency of each
+  call and the peak resident memory of both
+
+  Usage: Replay <trace file> [manager | malloc]
+
+  Every thread in the trace is replayed on a thread of its own. A free waits
+  until the allocation it frees has been replayed, wherever it came from, so
+  blocks still move between threads the way they did when the trace was made
+
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// Include Files
+//-----------------------------------------------------------------------------
+
+#include "../MemoryManager.h"
+#include "../MemoryTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Private Consts
+//-----------------------------------------------------------------------------
+
+const size_t RSS_INTERVAL = 4096; //!< the operations a thread replays between samples of the resident memory
+
+//-----------------------------------------------------------------------------
+// Private Classes
+//-----------------------------------------------------------------------------
+
+//! A single call to replay, the block is named by a slot instead of an address
+struct ReplayOp
+{
+  uint32_t slot;  //!< the index of the block in ReplayTrace::slotCount
+  uint32_t size;  //!< the bytes to allocate, unused for a free
+  uint8_t op;     //!< a MemoryTraceOp
+};
+
+//! A trace turned into the calls every thread makes, ready to replay
+struct ReplayTrace
+{
+  std::vector<std::vector<ReplayOp>> threads; //!< the calls of every traced thread in the order it made them
+  size_t slotCount = 0;                       //!< the number of blocks ever allocated, each gets a slot of its own
+  size_t opCount = 0;                         //!< the number of calls over all threads
+  std::vector<uint32_t> leaked;               //!< the slots of blocks the trace never freed, freed after the replay
+  size_t skipped = 0;                         //!< frees of blocks allocated before the trace started, not replayed
+};
+
+//! The functions an allocator is replayed with
+struct ReplayAllocator
+{
+  const char* name;               //!< the name results are printed under
+  void* (*allocate)(size_t size); //!< allocates a block
+  void (*destroy)(void* ptr);     //!< frees a block
+};
+
+//-----------------------------------------------------------------------------
+// Private Function Declerations
+//-----------------------------------------------------------------------------
+
+bool LoadTrace(const char* path, ReplayTrace& trace);
+void ReplayThread(const std::vector<ReplayOp>& ops, std::atomic<void*>* slots, const ReplayAllocator& allocator,
+                  uint32_t* latencies, std::atomic<size_t>* peakRSS);
+double ReplayRun(const ReplayTrace& trace, const ReplayAllocator& allocator, std::vector<uint32_t>* latencies,
+                 size_t* peakRSS);
+void ReplayAllocatorWork(const ReplayTrace& trace, const ReplayAllocator& allocator);
+void RunAllocator(const ReplayTrace& trace, const ReplayAllocator& allocator);
+uint32_t Percentile(const std::vector<uint32_t>& sorted, double fraction);
+size_t CurrentRSS(void);
+void* ManagerAllocate(size_t size);
+void ManagerDestroy(void* ptr);
+void* MallocAllocate(size_t size);
+void MallocDestroy(void* ptr);
+
+//-----------------------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  // if no trace was given
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: %s <trace file> [manager | malloc]\n", argv[0]);
+    return 1;
+  }
+
+  ReplayTrace trace;
+
+  // if the trace could not be read
+  if (!LoadTrace(argv[1], trace))
+  {
+    return 1;
+  }
+
+  printf("%zu calls on %zu threads, %zu frees of blocks from before the trace skipped\n",
+         trace.opCount, trace.threads.size(), trace.skipped);
+
+  const ReplayAllocator allocators[] = { { "manager", ManagerAllocate, ManagerDestroy },
+                                         { "malloc", MallocAllocate, MallocDestroy } };
+
+  // for all allocators
+  for (const ReplayAllocator& allocator : allocators)
+  {
+    // if only another allocator was asked for
+    if (argc > 2 && strcmp(argv[2], allocator.name) != 0)
+    {
+      continue;
+    }
+
+    RunAllocator(trace, allocator);
+  }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Private Functions
+//-----------------------------------------------------------------------------
+
+/*!****************************************************************************
+\brief
+  Reads a trace and turns it into the calls of every thread. The records are
+  put back in time order and every allocation is given a slot, so a free
+  names the allocation it undoes no matter which thread made it or how often
+  its address was reused
+
+\param path
+  the trace file
+
+\param trace
+  filled with the calls to replay
+
+\return
+  true if the trace was read, false if it could not be opened or is not a
+  trace
+******************************************************************************/
+bool LoadTrace(const char* path, ReplayTrace& trace)
+{
+  FILE* file = fopen(path, "rb");
+
+  // if the file could not be opened
+  if (file == NULL)
+  {
+    fprintf(stderr, "Can not open %s\n", path);
+    return false;
+  }
+
+  MemoryTraceHeader header;
+
+  // if the file does not start with a trace header of this version
+  if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "MMTRACE", sizeof(header.magic)) != 0 ||
+      header.version != TRACE_VERSION || header.recordSize != sizeof(MemoryTraceRecord))
+  {
+    fprintf(stderr, "%s is not a finished trace of version %u\n", path, TRACE_VERSION);
+    fclose(file);
+    return false;
+  }
+
+  // if records were lost the replay is missing calls
+  if (header.dropped)
+  {
+    fprintf(stderr, "The trace file filled up, %llu records were dropped\n", (unsigned long long)(header.dropped));
+  }
+
+  std::vector<MemoryTraceRecord> records;
+  MemoryTraceRecord run[TRACE_BUFFER_RECORDS];
+  size_t count;
+
+  records.reserve((size_t)(header.records));
+
+  // while there are records left in the file
+  while ((count = fread(run, sizeof(MemoryTraceRecord), TRACE_BUFFER_RECORDS, file)) != 0)
+  {
+    // for all records read
+    for (size_t i = 0; i < count; ++i)
+    {
+      // if the record was written, the end of a run that was not filled is left as 0
+      if (run[i].op != MEMORY_TRACE_NONE)
+      {
+        records.push_back(run[i]);
+      }
+    }
+  }
+
+  fclose(file);
+
+  // the records of one thread are already in order, a stable sort keeps the
+  // order of those that were stamped with the same time
+  std::stable_sort(records.begin(), records.end(),
+                   [](const MemoryTraceRecord& lhs, const MemoryTraceRecord& rhs) { return lhs.time < rhs.time; });
+
+  std::unordered_map<uint64_t, uint32_t> live; // the slot of every block allocated and not yet freed, by address
+
+  // for all records in time order
+  for (const MemoryTraceRecord& record : records)
+  {
+    ReplayOp op = { 0, record.size, record.op };
+
+    // if a block was allocated
+    if (record.op == MEMORY_TRACE_ALLOC)
+    {
+      op.slot = (uint32_t)(trace.slotCount++);
+      live[record.id] = op.slot;  // a block whose free was not recorded is left allocated
+    }
+    else
+    {
+      auto found = live.find(record.id);
+
+      // if the block was allocated before the trace started
+      if (found == live.end())
+      {
+        ++trace.skipped;
+        continue;
+      }
+
+      op.slot = found->second;
+      live.erase(found);
+    }
+
+    // if this is the first call of the thread
+    if (record.thread >= trace.threads.size())
+    {
+      trace.threads.resize(record.thread + 1);
+    }
+
+    trace.threads[record.thread].push_back(op);
+    ++trace.opCount;
+  }
+
+  // for all blocks that are still allocated at the end of the trace
+  for (const auto& block : live)
+  {
+    trace.leaked.push_back(block.second);
+  }
+
+  return true;
+}
+
+/*!****************************************************************************
+\brief
+  Replays the calls of one traced thread. A free of a block another thread
+  allocates waits until that thread has allocated it
+
+\param ops
+  the calls of the thread
+
+\param slots
+  the block in every slot, NULL until it is allocated
+
+\param allocator
+  the allocator to replay against
+
+\param latencies
+  set to the nanoseconds every call took, one per call, NULL to not time them
+
+\param peakRSS
+  raised to the most memory seen resident in kilobytes, NULL to not sample it
+******************************************************************************/
+void ReplayThread(const std::vector<ReplayOp>& ops, std::atomic<void*>* slots, const ReplayAllocator& allocator,
+                  uint32_t* latencies, std::atomic<size_t>* peakRSS)
+{
+  // for all calls of the thread
+  for (size_t i = 0; i < ops.size(); ++i)
+  {
+    const ReplayOp& op = ops[i];
+    std::atomic<void*>& slot = slots[op.slot];
+    void* block = NULL;
+
+    // if the block is allocated by another thread that has not got to it yet
+    while (op.op == MEMORY_TRACE_FREE && (block = slot.load(std::memory_order_acquire)) == NULL)
+    {
+      std::this_thread::yield();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // if a block is allocated
+    if (op.op == MEMORY_TRACE_ALLOC)
+    {
+      block = allocator.allocate(op.size);
+
+      // if the block has memory, touch it the way the program would
+      if (op.size)
+      {
+        *(char*)(block) = 0;
+      }
+
+      slot.store(block, std::memory_order_release);
+    }
+    else
+    {
+      allocator.destroy(block);
+    }
+
+    // if every call is timed
+    if (latencies)
+    {
+      latencies[i] = (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // if it is time to sample the resident memory
+    if (peakRSS && i % RSS_INTERVAL == 0)
+    {
+      size_t rss = CurrentRSS();
+      size_t peak = peakRSS->load(std::memory_order_relaxed);
+
+      // while another thread has not seen more
+      while (rss > peak && !peakRSS->compare_exchange_weak(peak, rss, std::memory_order_relaxed))
+      {
+      }
+    }
+  }
+}
+
+/*!****************************************************************************
+\brief
+  Replays the whole trace once with a thread per traced thread, then frees
+  every block the trace left allocated
+
+\param trace
+  the calls to replay
+
+\param allocator
+  the allocator to replay against
+
+\param latencies
+  filled with the nanoseconds every call took, NULL to not time them
+
+\param peakRSS
+  set to the most memory in kilobytes that was resident during the replay
+  on top of what was resident before it, NULL to not sample it
+
+\return
+  the seconds the replay took, without freeing what was left
+******************************************************************************/
+double ReplayRun(const ReplayTrace& trace, const ReplayAllocator& allocator, std::vector<uint32_t>* latencies,
+                 size_t* peakRSS)
+{
+  std::vector<std::atomic<void*>> slots(trace.slotCount);
+  std::vector<size_t> offsets(trace.threads.size(), 0);
+  std::vector<std::thread> threads;
+
+  // if every call is timed
+  if (latencies)
+  {
+    latencies->assign(trace.opCount, 0);
+
+    // for all threads but the first
+    for (size_t i = 1; i < trace.threads.size(); ++i)
+    {
+      offsets[i] = offsets[i - 1] + trace.threads[i - 1].size();
+    }
+  }
+
+  threads.reserve(trace.threads.size());
+
+  size_t startRSS = CurrentRSS();  // the slots and latencies are already resident
+  std::atomic<size_t> peak(startRSS);
+  auto start = std::chrono::steady_clock::now();
+
+  // for all traced threads
+  for (size_t i = 0; i < trace.threads.size(); ++i)
+  {
+    uint32_t* threadLatencies = latencies ? latencies->data() + offsets[i] : NULL;
+
+    threads.emplace_back(ReplayThread, std::cref(trace.threads[i]), slots.data(), std::cref(allocator), threadLatencies,
+                         peakRSS ? &peak : NULL);
+  }
+
+  // for all replay threads
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+  // if the resident memory was sampled
+  if (peakRSS)
+  {
+    *peakRSS = peak.load(std::memory_order_relaxed) - startRSS;
+  }
+
+  // for all blocks the trace left allocated
+  for (uint32_t slot : trace.leaked)
+  {
+    allocator.destroy(slots[slot].load(std::memory_order_relaxed));
+  }
+
+  return seconds.count();
+}
+
+/*!****************************************************************************
+\brief
+  Replays the trace against one allocator twice and prints what was
+  measured. The first replay times every call and samples the resident
+  memory while the allocator is fresh, the second is untimed and measures
+  the throughput of the allocator once it holds memory from the first
+
+\param trace
+  the calls to replay
+
+\param allocator
+  the allocator to replay against
+******************************************************************************/
+void ReplayAllocatorWork(const ReplayTrace& trace, const ReplayAllocator& allocator)
+{
+  size_t peakRSS = 0;
+  std::vector<uint32_t> latencies;
+
+  ReplayRun(trace, allocator, &latencies, &peakRSS);
+
+  double seconds = ReplayRun(trace, allocator, NULL, NULL);
+
+  std::sort(latencies.begin(), latencies.end());
+
+  printf("%-8s %12.0f calls/s  latency ns p50 %u p90 %u p99 %u p99.9 %u max %u  peak RSS %zu KB\n", allocator.name,
+         seconds > 0.0 ? trace.opCount / seconds : 0.0, Percentile(latencies, 0.5), Percentile(latencies, 0.9),
+         Percentile(latencies, 0.99), Percentile(latencies, 0.999), Percentile(latencies, 1.0), peakRSS);
+  fflush(stdout);
+}
+
+/*!****************************************************************************
+\brief
+  Replays the trace against one allocator. On Linux the replay runs in a
+  child process so neither allocator starts with memory the other one left
+
+\param trace
+  the calls to replay
+
+\param allocator
+  the allocator to replay against
+******************************************************************************/
+void RunAllocator(const ReplayTrace& trace, const ReplayAllocator& allocator)
+{
+#if defined(__linux__)
+  fflush(stdout);
+
+  pid_t child = fork();
+
+  // if this is the child process
+  if (child == 0)
+  {
+    ReplayAllocatorWork(trace, allocator);
+    _exit(0);
+  }
+
+  // if the child was started
+  if (child > 0)
+  {
+    waitpid(child, NULL, 0);
+  }
+#else
+  ReplayAllocatorWork(trace, allocator);
+#endif
+}
+
+/*!****************************************************************************
+\brief
+  Gets a percentile of a sorted set of latencies
+
+\param sorted
+  the latencies from smallest to largest
+
+\param fraction
+  the percentile between 0 and 1, 1 is the largest
+
+\return
+  the latency in nanoseconds, 0 if there are none
+******************************************************************************/
+uint32_t Percentile(const std::vector<uint32_t>& sorted, double fraction)
+{
+  // if nothing was timed
+  if (sorted.empty())
+  {
+    return 0;
+  }
+
+  size_t index = (size_t)(fraction * (sorted.size() - 1));
+
+  return sorted[index];
+}
+
+/*!****************************************************************************
+\brief
+  Gets the memory the process has resident right now
+
+\return
+  the resident set size in kilobytes
+******************************************************************************/
+size_t CurrentRSS(void)
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+  return counters.WorkingSetSize / 1024;
+#elif defined(__linux__)
+  FILE* file = fopen("/proc/self/statm", "r");
+  size_t size = 0;
+  size_t resident = 0;
+
+  // if the process statistics could be read
+  if (file)
+  {
+    // if the numbers could not be read
+    if (fscanf(file, "%zu %zu", &size, &resident) != 2)
+    {
+      resident = 0;
+    }
+
+    fclose(file);
+  }
+
+  return resident * (size_t)(sysconf(_SC_PAGESIZE)) / 1024;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  return (size_t)(usage.ru_maxrss);
+#endif
+}
+
+void* ManagerAllocate(size_t size)
+{
+  return Alloc(size);
+}
+
+void ManagerDestroy(void* ptr)
+{
+  Delete(ptr);
+}
+
+void* MallocAllocate(size_t size)
+{
+  return malloc(size);
+}
+
+void MallocDestroy(void* ptr)
+{
+  free(ptr);
+}